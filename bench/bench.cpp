@@ -0,0 +1,148 @@
+#include <benchmark/benchmark.h>
+#include <complex>
+#include <tuple>
+#include <toy-gemm/matrix.hpp>
+
+using namespace toy_gemm;
+
+namespace
+{
+template <size_t R, size_t C, typename T>
+Mat<R, C, T> make_mat(size_t seed)
+{
+    Mat<R, C, T> m;
+    for (size_t r = 0; r < R; ++r) {
+        for (size_t c = 0; c < C; ++c) {
+            m.at(r, c) = static_cast<T>(static_cast<int>((r * 7 + c * 13 + seed * 5) % 11) - 5);
+        }
+    }
+    return m;
+}
+
+/**
+ * @brief report rates per iteration: flops as FLOP/s (a multiply-add counts as two, whatever the element type) and
+ * the bytes every iteration has to read and write at least once as bytes/s
+ */
+void set_rates(benchmark::State &state, double flops, size_t bytes)
+{
+    if (flops > 0) {
+        state.counters["FLOP/s"] = benchmark::Counter(flops * static_cast<double>(state.iterations()),
+                                                      benchmark::Counter::kIsRate, benchmark::Counter::kIs1000);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes * state.iterations()));
+}
+
+template <size_t M, size_t K, size_t N, typename T>
+void bm_multiply(benchmark::State &state)
+{
+    const auto a = make_mat<M, K, T>(1);
+    const auto b = make_mat<K, N, T>(2);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+        auto c = a * b;
+        benchmark::DoNotOptimize(c);
+    }
+    set_rates(state, 2.0 * M * N * K, (M * K + K * N + M * N) * sizeof(T));
+}
+
+template <size_t R, size_t C, typename T>
+void bm_transpose(benchmark::State &state)
+{
+    const auto a = make_mat<R, C, T>(1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        auto t = a.transpose();
+        benchmark::DoNotOptimize(t);
+    }
+    set_rates(state, 0, 2 * R * C * sizeof(T));
+}
+
+template <size_t R, size_t C, typename T>
+void bm_get_col(benchmark::State &state)
+{
+    const auto a = make_mat<R, C, T>(1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        auto col = a.template get_col<C / 2>();
+        benchmark::DoNotOptimize(col);
+    }
+    set_rates(state, 0, 2 * R * sizeof(T));
+}
+
+template <size_t R, size_t C, typename T>
+void bm_col_view(benchmark::State &state)
+{
+    auto a = make_mat<R, C, T>(1);
+    for (auto _ : state) {
+        // read-modify-write a whole column through the view
+        std::apply([](auto &... e) { ((e += T{1}), ...); }, a.template col_view<C / 2>());
+        benchmark::ClobberMemory();
+    }
+    set_rates(state, 0, 2 * R * sizeof(T));
+}
+
+template <size_t R, size_t C, typename T>
+void bm_equal(benchmark::State &state)
+{
+    const auto a = make_mat<R, C, T>(1);
+    const auto b = a;  // equal, so every element gets compared
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+        bool eq = a == b;
+        benchmark::DoNotOptimize(eq);
+    }
+    set_rates(state, 0, 2 * R * C * sizeof(T));
+}
+
+template <size_t R, size_t C, typename T>
+void bm_construct(benchmark::State &state)
+{
+    T value{1};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(value);
+        Mat<R, C, T> m(value);
+        benchmark::DoNotOptimize(m);
+    }
+    set_rates(state, 0, R * C * sizeof(T));
+}
+
+using Complex = std::complex<double>;
+}  // namespace
+
+// one set of shapes per element type; square, then rectangular: outer-product like, inner-product like and ragged
+
+#define TOY_GEMM_BENCH_MULTIPLY(T)                      \
+    BENCHMARK_TEMPLATE(bm_multiply, 4, 4, 4, T);        \
+    BENCHMARK_TEMPLATE(bm_multiply, 16, 16, 16, T);     \
+    BENCHMARK_TEMPLATE(bm_multiply, 64, 64, 64, T);     \
+    BENCHMARK_TEMPLATE(bm_multiply, 128, 128, 128, T);  \
+    BENCHMARK_TEMPLATE(bm_multiply, 256, 256, 256, T);  \
+    BENCHMARK_TEMPLATE(bm_multiply, 256, 16, 256, T);   \
+    BENCHMARK_TEMPLATE(bm_multiply, 16, 256, 16, T);    \
+    BENCHMARK_TEMPLATE(bm_multiply, 100, 70, 130, T)
+
+#define TOY_GEMM_BENCH_SHAPES(bm, T)      \
+    BENCHMARK_TEMPLATE(bm, 4, 4, T);      \
+    BENCHMARK_TEMPLATE(bm, 16, 16, T);    \
+    BENCHMARK_TEMPLATE(bm, 64, 64, T);    \
+    BENCHMARK_TEMPLATE(bm, 256, 256, T);  \
+    BENCHMARK_TEMPLATE(bm, 256, 16, T);   \
+    BENCHMARK_TEMPLATE(bm, 16, 256, T)
+
+// col_view returns a tuple of R references, so it stays at moderate heights
+#define TOY_GEMM_BENCH_ALL(T)                       \
+    TOY_GEMM_BENCH_MULTIPLY(T);                     \
+    TOY_GEMM_BENCH_SHAPES(bm_transpose, T);         \
+    TOY_GEMM_BENCH_SHAPES(bm_get_col, T);           \
+    TOY_GEMM_BENCH_SHAPES(bm_equal, T);             \
+    TOY_GEMM_BENCH_SHAPES(bm_construct, T);         \
+    BENCHMARK_TEMPLATE(bm_col_view, 4, 4, T);       \
+    BENCHMARK_TEMPLATE(bm_col_view, 16, 16, T);     \
+    BENCHMARK_TEMPLATE(bm_col_view, 64, 8, T)
+
+TOY_GEMM_BENCH_ALL(int);
+TOY_GEMM_BENCH_ALL(float);
+TOY_GEMM_BENCH_ALL(double);
+TOY_GEMM_BENCH_ALL(Complex);
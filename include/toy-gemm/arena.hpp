@@ -0,0 +1,273 @@
+#ifndef TOY_GEMM_ARENA_HPP
+#define TOY_GEMM_ARENA_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Thread-local arenas for the scratch memory of the gemm engine, e.g. its packing buffers. Every thread, the workers of
+ * the thread pool included, keeps the memory it once needed and hands it out again on the next product, so once the
+ * largest product has run a thread does not go to the heap anymore:
+ * @code
+ * A * B;                                     // the first product of this size grows the arena
+ * const auto before = arena::stats();
+ * A * B;                                     // this one reuses it
+ * assert(arena::stats().heap_allocations == before.heap_allocations);
+ * @endcode
+ * Scratch memory is taken and given back in LIFO order, through the scoped \ref arena::Buffer
+ */
+
+namespace toy_gemm
+{
+namespace arena
+{
+/**
+ * @brief counters of one arena, or summed over the arenas of all threads
+ */
+struct Stats {
+    size_t requests = 0;          ///< buffers handed out
+    size_t heap_allocations = 0;  ///< blocks allocated on the heap to serve them
+    size_t bytes_reserved = 0;    ///< memory held, in use or not
+    size_t bytes_in_use = 0;      ///< memory handed out and not given back yet
+    size_t peak_bytes = 0;        ///< the most bytes_in_use has been
+};
+
+namespace detail
+{
+/**
+ * @brief the counters of all threads together; atomics, since every thread updates its own share
+ */
+struct GlobalStats {
+    std::atomic<size_t> requests{0};
+    std::atomic<size_t> heap_allocations{0};
+    std::atomic<size_t> bytes_reserved{0};
+    std::atomic<size_t> bytes_in_use{0};
+    std::atomic<size_t> peak_bytes{0};
+};
+
+inline GlobalStats &global_stats() noexcept
+{
+    static GlobalStats stats;
+    return stats;
+}
+}  // namespace detail
+
+/**
+ * @brief bump allocator over a list of 64-byte aligned blocks, one per thread (see \ref local)
+ * allocations are given back in reverse order by restoring the mark taken before them. Blocks are kept once
+ * allocated; when nothing is in use and the arena had to grow into several blocks, they are merged into one block
+ * as large as all of them, so the next round of the same requests fits without growing
+ */
+class Arena
+{
+   public:
+    constexpr static size_t ALIGNMENT = 64;
+    constexpr static size_t MIN_BLOCK = 64 * 1024;  ///< smallest block requested from the heap, in bytes
+
+    /**
+     * @brief a position in the arena; everything allocated after it is given back by \ref release_to
+     */
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    ~Arena()
+    {
+        auto &global = detail::global_stats();
+        global.bytes_reserved -= stats_.bytes_reserved;
+        global.bytes_in_use -= stats_.bytes_in_use;
+    }
+
+    [[nodiscard]] Mark mark() const noexcept { return {current_, offset_}; }
+
+    /**
+     * @return bytes of memory aligned to ALIGNMENT, valid until the arena gets released to a mark taken before
+     */
+    [[nodiscard]] void *allocate(size_t bytes)
+    {
+        bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        while (current_ < blocks_.size() && offset_ + bytes > blocks_[current_].size) {
+            ++current_;
+            offset_ = 0;
+        }
+        if (current_ == blocks_.size()) {
+            const size_t last = blocks_.empty() ? 0 : blocks_.back().size;
+            add_block(std::max({bytes, MIN_BLOCK, 2 * last}));
+            offset_ = 0;
+        }
+        void *p = blocks_[current_].data.get() + offset_;
+        offset_ += bytes;
+        ++stats_.requests;
+        ++detail::global_stats().requests;
+        update_in_use();
+        return p;
+    }
+
+    /**
+     * @brief give back everything allocated since m was taken
+     */
+    void release_to(const Mark &m) noexcept
+    {
+        current_ = m.block;
+        offset_ = m.offset;
+        update_in_use();
+        if (stats_.bytes_in_use == 0 && blocks_.size() > 1) merge_blocks();
+    }
+
+    /**
+     * @brief free the memory of this arena; only while nothing is in use
+     */
+    void shrink() noexcept
+    {
+        if (stats_.bytes_in_use != 0) return;
+        detail::global_stats().bytes_reserved -= stats_.bytes_reserved;
+        stats_.bytes_reserved = 0;
+        blocks_.clear();
+        current_ = 0;
+        offset_ = 0;
+    }
+
+    [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+   private:
+    struct Deleter {
+        void operator()(std::byte *p) const noexcept { ::operator delete(p, std::align_val_t{ALIGNMENT}); }
+    };
+
+    struct Block {
+        std::unique_ptr<std::byte, Deleter> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    size_t current_ = 0;  ///< the block allocations come from
+    size_t offset_ = 0;   ///< bytes in use in the current block
+    Stats stats_;
+
+    void add_block(size_t bytes)
+    {
+        auto *p = static_cast<std::byte *>(::operator new(bytes, std::align_val_t{ALIGNMENT}));
+        blocks_.push_back({std::unique_ptr<std::byte, Deleter>(p), bytes});
+        stats_.bytes_reserved += bytes;
+        ++stats_.heap_allocations;
+        auto &global = detail::global_stats();
+        global.bytes_reserved += bytes;
+        ++global.heap_allocations;
+    }
+
+    /**
+     * @brief replace every block by one as large as all of them; keeps the blocks as they are if that fails
+     */
+    void merge_blocks() noexcept
+    {
+        const size_t total = stats_.bytes_reserved;
+        auto *p = static_cast<std::byte *>(::operator new(total, std::align_val_t{ALIGNMENT}, std::nothrow));
+        if (p == nullptr) return;
+        blocks_.clear();
+        blocks_.push_back({std::unique_ptr<std::byte, Deleter>(p), total});  // within capacity, can't throw
+        ++stats_.heap_allocations;
+        ++detail::global_stats().heap_allocations;
+        current_ = 0;
+        offset_ = 0;
+    }
+
+    void update_in_use() noexcept
+    {
+        size_t in_use = offset_;
+        for (size_t i = 0; i < current_; ++i) in_use += blocks_[i].size;
+        auto &global = detail::global_stats();
+        if (in_use >= stats_.bytes_in_use) {
+            global.bytes_in_use += in_use - stats_.bytes_in_use;
+        } else {
+            global.bytes_in_use -= stats_.bytes_in_use - in_use;
+        }
+        stats_.bytes_in_use = in_use;
+        if (in_use > stats_.peak_bytes) stats_.peak_bytes = in_use;
+        size_t peak = global.peak_bytes.load(std::memory_order_relaxed);
+        const size_t total = global.bytes_in_use.load(std::memory_order_relaxed);
+        while (total > peak && !global.peak_bytes.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+        }
+    }
+};
+
+/**
+ * @return the arena of the calling thread
+ */
+inline Arena &local()
+{
+    thread_local Arena arena;
+    return arena;
+}
+
+/**
+ * @return the counters of the arena of the calling thread
+ */
+inline Stats stats() { return local().stats(); }
+
+/**
+ * @return the counters summed over the arenas of all threads; peak_bytes is the most memory in use at once
+ */
+inline Stats total_stats() noexcept
+{
+    const auto &global = detail::global_stats();
+    Stats ret;
+    ret.requests = global.requests.load(std::memory_order_relaxed);
+    ret.heap_allocations = global.heap_allocations.load(std::memory_order_relaxed);
+    ret.bytes_reserved = global.bytes_reserved.load(std::memory_order_relaxed);
+    ret.bytes_in_use = global.bytes_in_use.load(std::memory_order_relaxed);
+    ret.peak_bytes = global.peak_bytes.load(std::memory_order_relaxed);
+    return ret;
+}
+
+/**
+ * @brief free the memory the arena of the calling thread holds, unless some of it is in use
+ */
+inline void shrink() { local().shrink(); }
+
+/**
+ * @brief n default-initialized elements of T from the arena of the calling thread, given back when the buffer goes
+ * out of scope; buffers of a thread have to go out of scope in the reverse order they were made, so they can't be moved
+ * @tparam T trivially destructible, since the memory is reused without destroying the elements
+ */
+template <typename T>
+class Buffer
+{
+    static_assert(std::is_trivially_destructible_v<T>, "arena memory is reused without running destructors");
+    static_assert(alignof(T) <= Arena::ALIGNMENT, "arena memory is only aligned to Arena::ALIGNMENT");
+
+   public:
+    explicit Buffer(size_t n) : arena_(&local()), mark_(arena_->mark()), n_(n)
+    {
+        data_ = static_cast<T *>(arena_->allocate(n * sizeof(T)));
+        std::uninitialized_default_construct_n(data_, n);
+    }
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    ~Buffer() { arena_->release_to(mark_); }
+
+    [[nodiscard]] T *data() noexcept { return data_; }
+    [[nodiscard]] const T *data() const noexcept { return data_; }
+    [[nodiscard]] size_t size() const noexcept { return n_; }
+
+   private:
+    Arena *arena_;
+    Arena::Mark mark_;
+    size_t n_;
+    T *data_;
+};
+}  // namespace arena
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_ARENA_HPP
@@ -0,0 +1,152 @@
+#ifndef TOY_GEMM_CHAIN_HPP
+#define TOY_GEMM_CHAIN_HPP
+
+#include <array>
+#include <tuple>
+#include <type_traits>
+
+#include "matrix.hpp"
+
+/**
+ * Matrix-chain multiplication. The cost of a product of several matrices depends a lot on the order the pairwise
+ * products are evaluated in: with A 10 x 1000, B 1000 x 10 and C 10 x 1000, (A * B) * C takes 200'000 multiplications
+ * while A * (B * C) takes 20'000'000. Since every dimension of a \ref Mat is known at compile time, \ref chain runs the
+ * textbook dynamic program at compile time and evaluates in the cheapest order:
+ * @code
+ * auto m = chain(A, B, C, D);  // same result as A * B * C * D, cheapest parenthesization
+ * @endcode
+ */
+
+namespace toy_gemm
+{
+namespace detail
+{
+template <typename X>
+constexpr bool IS_MAT = false;
+
+template <size_t R, size_t C, typename T, typename S, typename L>
+constexpr bool IS_MAT<Mat<R, C, T, S, L>> = true;
+
+/**
+ * @brief cheapest parenthesization of a chain of N matrices; the i-th matrix is dims[i] x dims[i + 1]
+ */
+template <size_t N>
+struct ChainPlan final {
+    std::array<std::array<size_t, N>, N> cost{};   ///< scalar multiplications for the sub-chain [i, j]
+    std::array<std::array<size_t, N>, N> split{};  ///< [i, j] is evaluated as [i, split] * [split + 1, j]
+};
+
+/**
+ * @brief the O(N^3) dynamic program of CLRS 15.2, with ties going to the left-most split, i.e. left to right
+ */
+template <size_t N>
+[[nodiscard]] constexpr ChainPlan<N> plan_chain(const std::array<size_t, N + 1> &dims) noexcept
+{
+    ChainPlan<N> plan;
+    for (size_t len = 2; len <= N; ++len) {
+        for (size_t i = 0; i + len <= N; ++i) {
+            const size_t j = i + len - 1;
+            for (size_t k = i; k < j; ++k) {
+                const size_t cost = plan.cost[i][k] + plan.cost[k + 1][j] + dims[i] * dims[k + 1] * dims[j + 1];
+                if (k == i || cost < plan.cost[i][j]) {
+                    plan.cost[i][j] = cost;
+                    plan.split[i][j] = k;
+                }
+            }
+        }
+    }
+    return plan;
+}
+
+/**
+ * @brief scalar multiplications needed to evaluate the chain strictly left to right
+ */
+template <size_t N>
+[[nodiscard]] constexpr size_t left_to_right_cost(const std::array<size_t, N + 1> &dims) noexcept
+{
+    size_t cost = 0;
+    for (size_t i = 1; i < N; ++i) cost += dims[0] * dims[i] * dims[i + 1];
+    return cost;
+}
+}  // namespace detail
+
+/**
+ * @brief the evaluation plan of the chain M[0] * M[1] * ... * M[N - 1], all of it computed at compile time
+ * @tparam M \ref Mat types, each with as many rows as the previous one has columns
+ */
+template <typename... M>
+struct ChainOrder final {
+    ChainOrder() = delete;  ///< don't bother generating special functions
+
+    static_assert(sizeof...(M) > 0, "a chain needs at least one matrix");
+    static_assert((detail::IS_MAT<M> && ...), "only Mat has all its dimensions known at compile time");
+
+    constexpr static size_t N = sizeof...(M);
+    constexpr static std::array<size_t, N> ROWS{M::ROW_COUNT...};
+    constexpr static std::array<size_t, N> COLS{M::COL_COUNT...};
+
+    /**
+     * @return whether each matrix has as many rows as the previous one has columns
+     */
+    [[nodiscard]] constexpr static bool conformable() noexcept
+    {
+        for (size_t i = 1; i < N; ++i) {
+            if (ROWS[i] != COLS[i - 1]) return false;
+        }
+        return true;
+    }
+    static_assert(conformable(), "each matrix must have as many rows as the previous one has columns");
+
+    /**
+     * @return {ROWS[0], COLS[0], COLS[1], ... COLS[N - 1]}
+     */
+    [[nodiscard]] constexpr static std::array<size_t, N + 1> dims() noexcept
+    {
+        std::array<size_t, N + 1> ret{ROWS[0]};
+        for (size_t i = 0; i < N; ++i) ret[i + 1] = COLS[i];
+        return ret;
+    }
+
+    constexpr static detail::ChainPlan<N> PLAN = detail::plan_chain<N>(dims());
+    constexpr static size_t OPTIMAL_COST = PLAN.cost[0][N - 1];                     ///< of the chosen order
+    constexpr static size_t LEFT_TO_RIGHT_COST = detail::left_to_right_cost<N>(dims());  ///< of A * B * C * ...
+
+    /**
+     * @return where the sub-chain [I, J] is split; e.g. split(0, N - 1) == 0 means M[0] * (M[1] * ... * M[N - 1])
+     */
+    [[nodiscard]] constexpr static size_t split(size_t i, size_t j) noexcept { return PLAN.split[i][j]; }
+
+    /**
+     * @brief evaluate the sub-chain [I, J] in the planned order
+     * @param operands references to all N matrices of the chain
+     * @return a reference to the operand itself when I == J, so single matrices are never copied; a new matrix
+     * otherwise
+     */
+    template <size_t I, size_t J>
+    [[nodiscard]] constexpr static decltype(auto) eval(const std::tuple<const M &...> &operands)
+    {
+        if constexpr (I == J) {
+            return (std::get<I>(operands));  // parenthesized so decltype(auto) deduces a reference
+        } else {
+            constexpr size_t K = PLAN.split[I][J];
+            return eval<I, K>(operands) * eval<K + 1, J>(operands);
+        }
+    }
+};
+
+/**
+ * @brief multiply a chain of matrices in the order that takes the fewest scalar multiplications
+ * the order is decided at compile time (see \ref ChainOrder); each pairwise product goes through Mat::operator*, so
+ * the result, including its element type, is the same as that of m[0] * m[1] * ... up to rounding
+ * @param m two or more \ref Mat, each with as many rows as the previous one has columns
+ * @return the product of all of m
+ */
+template <typename... M>
+[[nodiscard]] constexpr auto chain(const M &... m)
+{
+    using Order = ChainOrder<M...>;
+    return Order::template eval<0, Order::N - 1>(std::tuple<const M &...>(m...));  // C++ template disambiguator
+}
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_CHAIN_HPP
@@ -0,0 +1,140 @@
+#ifndef TOY_GEMM_CPU_HPP
+#define TOY_GEMM_CPU_HPP
+
+#include <atomic>
+
+/**
+ * TOY_GEMM_X86_DISPATCH is 1 when every x86 kernel can be compiled regardless of -march and picked at runtime; this
+ * needs GCC or clang, whose target pragmas let a header carry code for instruction sets the rest of the translation
+ * unit was not compiled for. Otherwise only the kernels enabled by the compiler flags are built.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TOY_GEMM_X86_DISPATCH 1
+#include <cpuid.h>
+#else
+#define TOY_GEMM_X86_DISPATCH 0
+#endif
+
+// TOY_GEMM_TARGET_<ISA>_BEGIN ... TOY_GEMM_TARGET_END compiles every function in between for that instruction set
+#if TOY_GEMM_X86_DISPATCH && defined(__clang__)
+#define TOY_GEMM_TARGET_SSE4_2_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"sse4.2\"))), apply_to = function)")
+#define TOY_GEMM_TARGET_AVX2_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+#define TOY_GEMM_TARGET_AVX512_BEGIN \
+    _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx2,fma\"))), apply_to = function)")
+#define TOY_GEMM_TARGET_END _Pragma("clang attribute pop")
+#elif TOY_GEMM_X86_DISPATCH
+#define TOY_GEMM_TARGET_SSE4_2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"sse4.2\")")
+#define TOY_GEMM_TARGET_AVX2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+#define TOY_GEMM_TARGET_AVX512_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+#define TOY_GEMM_TARGET_END _Pragma("GCC pop_options")
+#else
+#define TOY_GEMM_TARGET_SSE4_2_BEGIN
+#define TOY_GEMM_TARGET_AVX2_BEGIN
+#define TOY_GEMM_TARGET_AVX512_BEGIN
+#define TOY_GEMM_TARGET_END
+#endif
+
+namespace toy_gemm
+{
+namespace cpu
+{
+/**
+ * @brief instruction sets with dedicated kernels, each one a superset of the previous
+ */
+enum class Isa : int { GENERIC = 0, SSE4_2, AVX2, AVX512 };
+
+[[nodiscard]] constexpr const char *name(Isa isa) noexcept
+{
+    switch (isa) {
+        case Isa::SSE4_2:
+            return "sse4.2";
+        case Isa::AVX2:
+            return "avx2";
+        case Isa::AVX512:
+            return "avx512";
+        default:
+            return "generic";
+    }
+}
+
+/**
+ * @brief query the widest instruction set that both the CPU and the OS (which has to save the wider registers on
+ * context switches) support
+ * without runtime dispatch this is simply the widest instruction set the compiler was told to target
+ */
+[[nodiscard]] inline Isa detect() noexcept
+{
+#if TOY_GEMM_X86_DISPATCH
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return Isa::GENERIC;
+    const bool sse4_2 = ecx & bit_SSE4_2;
+    const bool osxsave = ecx & bit_OSXSAVE;
+    const bool avx = ecx & bit_AVX;
+    const bool fma = ecx & bit_FMA;
+    if (!sse4_2) return Isa::GENERIC;
+    if (!(osxsave && avx && fma)) return Isa::SSE4_2;
+
+    unsigned xcr0_lo = 0, xcr0_hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    constexpr unsigned XMM_YMM = 0x6;      // SSE and AVX state
+    constexpr unsigned OPMASK_ZMM = 0xe0;  // AVX-512 state
+    if ((xcr0_lo & XMM_YMM) != XMM_YMM) return Isa::SSE4_2;
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2)) return Isa::SSE4_2;
+    if (!(ebx & bit_AVX512F) || (xcr0_lo & OPMASK_ZMM) != OPMASK_ZMM) return Isa::AVX2;
+    return Isa::AVX512;
+#elif defined(__AVX512F__)
+    return Isa::AVX512;
+#elif defined(__AVX2__) && defined(__FMA__)
+    return Isa::AVX2;
+#elif defined(__SSE4_2__)
+    return Isa::SSE4_2;
+#else
+    return Isa::GENERIC;
+#endif
+}
+
+/**
+ * @return the result of \ref detect, computed on first use
+ */
+[[nodiscard]] inline Isa supported_isa() noexcept
+{
+    static const Isa isa = detect();  // thread-safe initialization
+    return isa;
+}
+
+namespace detail
+{
+inline std::atomic<Isa> &active_isa() noexcept
+{
+    static std::atomic<Isa> isa{supported_isa()};
+    return isa;
+}
+}  // namespace detail
+
+/**
+ * @return the instruction set whose kernels are dispatched to; \ref supported_isa unless lowered by \ref set_isa
+ */
+[[nodiscard]] inline Isa active_isa() noexcept
+{
+    return detail::active_isa().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief restrict dispatch to kernels of at most the given instruction set; mostly useful for testing and benchmarking
+ * the narrower kernels on a wide machine
+ * @return the instruction set actually in effect, which never exceeds \ref supported_isa
+ */
+inline Isa set_isa(Isa isa) noexcept
+{
+    const Isa effective = isa < supported_isa() ? isa : supported_isa();
+    detail::active_isa().store(effective, std::memory_order_relaxed);
+    return effective;
+}
+
+}  // namespace cpu
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_CPU_HPP
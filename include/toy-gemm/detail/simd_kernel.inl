@@ -0,0 +1,55 @@
+// included by kernels.hpp once per instruction set, inside that instruction set's namespace, after its Ops structs;
+// no include guard on purpose
+
+/**
+ * @brief register-blocked microkernel over one instruction set's vectors
+ * the MR x NV accumulators stay in vector registers for the whole kc loop: every step loads NV vectors from the B
+ * sliver, broadcasts MR elements of the A sliver and does MR * NV fused multiply-adds
+ * @tparam Ops load/store/arithmetic wrappers for one (instruction set, element type) pair
+ * @tparam MR rows of the register block
+ * @tparam NV vectors per row of the register block, so NR is NV * Ops::WIDTH
+ */
+template <typename Ops, size_t MR, size_t NV>
+void simd_kernel(size_t kc, const typename Ops::Elem *a, const typename Ops::Elem *b, typename Ops::Elem *c,
+                 std::ptrdiff_t rs_c, std::ptrdiff_t cs_c, typename Ops::Elem alpha, typename Ops::Elem beta)
+{
+    using T = typename Ops::Elem;
+    using V = typename Ops::Vec;
+    constexpr size_t W = Ops::WIDTH;
+    constexpr size_t NR = NV * W;
+
+    V acc[MR][NV];
+    for (size_t i = 0; i < MR; ++i) {
+        for (size_t v = 0; v < NV; ++v) acc[i][v] = Ops::zero();
+    }
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        V bv[NV];
+        for (size_t v = 0; v < NV; ++v) bv[v] = Ops::load(b + v * W);
+        for (size_t i = 0; i < MR; ++i) {
+            const V av = Ops::broadcast(a[i]);
+            for (size_t v = 0; v < NV; ++v) acc[i][v] = Ops::fmadd(av, bv[v], acc[i][v]);
+        }
+    }
+
+    const V va = Ops::broadcast(alpha);
+    const V vb = Ops::broadcast(beta);
+    const bool overwrite = beta == T{};
+    for (size_t i = 0; i < MR; ++i) {
+        T *row = c + static_cast<std::ptrdiff_t>(i) * rs_c;
+        for (size_t v = 0; v < NV; ++v) {
+            V r = Ops::mul(va, acc[i][v]);
+            if (cs_c == 1) {
+                if (!overwrite) r = Ops::fmadd(vb, Ops::load(row + v * W), r);
+                Ops::store(row + v * W, r);
+                continue;
+            }
+            // C is not contiguous along a row, so go through memory one element at a time
+            T lanes[W];
+            Ops::store(lanes, r);
+            for (size_t j = 0; j < W; ++j) {
+                T &dst = row[static_cast<std::ptrdiff_t>(v * W + j) * cs_c];
+                dst = overwrite ? lanes[j] : lanes[j] + beta * dst;
+            }
+        }
+    }
+}
@@ -0,0 +1,787 @@
+#ifndef TOY_GEMM_DYN_MATRIX_HPP
+#define TOY_GEMM_DYN_MATRIX_HPP
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "gemm.hpp"
+#include "matrix.hpp"
+
+namespace toy_gemm
+{
+/**
+ * @brief non-owning view of a contiguous run of elements; a row of a \ref DynMat
+ * plays the role std::array (\ref Vec) plays for \ref Mat: range for, size(), operator[] and at()
+ */
+template <typename T>
+class RowView
+{
+   public:
+    using value_type = std::remove_const_t<T>;
+    using iterator = T *;
+
+    constexpr RowView(T *data, size_t size) noexcept : data_(data), size_(size) {}
+
+    constexpr operator RowView<const T>() const noexcept { return {data_, size_}; }  // NOLINT: implicit on purpose
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return size_; }
+    [[nodiscard]] constexpr T *data() const noexcept { return data_; }
+    [[nodiscard]] constexpr iterator begin() const noexcept { return data_; }
+    [[nodiscard]] constexpr iterator end() const noexcept { return data_ + size_; }
+
+    [[nodiscard]] constexpr T &operator[](size_t c) const noexcept
+    {
+        detail::check_index(c, size_, "column");
+        return data_[c];
+    }
+
+    [[nodiscard]] constexpr T &at(size_t c) const
+    {
+        if (c >= size_) throw std::out_of_range("column index out of range");
+        return data_[c];
+    }
+
+    template <typename E>
+    [[nodiscard]] bool operator==(const RowView<E> &other) const noexcept
+    {
+        return size_ == other.size() && std::equal(begin(), end(), other.begin());
+    }
+
+    template <typename E>
+    [[nodiscard]] bool operator!=(const RowView<E> &other) const noexcept
+    {
+        return !this->operator==(other);
+    }
+
+   private:
+    T *data_;
+    size_t size_;
+};
+
+/**
+ * @brief forward range over the rows of a matrix whose rows sit ld elements apart
+ */
+template <typename T>
+class RowRange
+{
+   public:
+    class iterator
+    {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RowView<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = RowView<T>;
+
+        constexpr iterator(T *row, size_t cols, size_t ld) noexcept : row_(row), cols_(cols), ld_(ld) {}
+
+        [[nodiscard]] constexpr RowView<T> operator*() const noexcept { return {row_, cols_}; }
+
+        constexpr iterator &operator++() noexcept
+        {
+            row_ += ld_;
+            return *this;
+        }
+
+        constexpr iterator operator++(int) noexcept
+        {
+            iterator ret = *this;
+            row_ += ld_;
+            return ret;
+        }
+
+        [[nodiscard]] constexpr bool operator==(const iterator &other) const noexcept { return row_ == other.row_; }
+        [[nodiscard]] constexpr bool operator!=(const iterator &other) const noexcept { return row_ != other.row_; }
+
+       private:
+        T *row_;
+        size_t cols_;
+        size_t ld_;
+    };
+
+    constexpr RowRange(T *data, size_t rows, size_t cols, size_t ld) noexcept
+        : data_(data), rows_(rows), cols_(cols), ld_(ld)
+    {
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return rows_; }
+    [[nodiscard]] constexpr iterator begin() const noexcept { return {data_, cols_, ld_}; }
+    [[nodiscard]] constexpr iterator end() const noexcept { return {data_ + rows_ * ld_, cols_, ld_}; }
+
+   private:
+    T *data_;
+    size_t rows_;
+    size_t cols_;
+    size_t ld_;
+};
+
+template <typename T = int>
+class DynMat;
+
+template <typename T>
+class MatMap;
+
+namespace detail
+{
+/**
+ * @brief matrices whose dimensions are only known at runtime, owning (DynMat) or not (MatMap); any of them mixes with
+ * any other
+ */
+template <typename X>
+constexpr bool IS_DYN = false;
+
+template <typename T>
+constexpr bool IS_DYN<DynMat<T>> = true;
+
+template <typename T>
+constexpr bool IS_DYN<MatMap<T>> = true;
+
+/**
+ * @brief run the gemm engine on two operands of compatible shapes into a new m x n DynMat
+ * @tparam T element type of the lhs
+ * @tparam E element type of the rhs
+ */
+template <typename T, typename E, typename AView, typename BView>
+[[nodiscard]] auto dyn_product(size_t m, size_t n, size_t k, const AView &a, const BView &b)
+{
+    // same promotion rule as Mat::operator*
+    using RetElement = decltype(std::declval<E>() * std::declval<T>());
+    DynMat<RetElement> ret(m, n);
+    engine::gemm(m, n, k, RetElement{1}, a, b, RetElement{}, ret.view());
+    return ret;
+}
+
+/**
+ * @brief the accessors and operators DynMat and MatMap share, written once over the data(), ld(), row_count() and
+ * col_count() of Derived; results of operations are DynMats
+ * @tparam Derived the matrix type, DynMat<T> or MatMap<T>
+ * @tparam T its element type
+ */
+template <typename Derived, typename T>
+class DynBase
+{
+   public:
+    using ResultType = DynMat<std::remove_const_t<T>>;
+    using ElemType = T;
+    using RowType = RowView<T>;
+    using ConstRowType = RowView<const T>;
+
+    // dimensions
+    [[nodiscard]] size_t elem_count() const noexcept { return self().row_count() * self().col_count(); }
+
+    // unchecked access; see \ref Mat::operator[]
+    [[nodiscard]] ConstRowType operator[](size_t r) const noexcept
+    {
+        detail::check_index(r, self().row_count(), "row");
+        return {row_data(r), self().col_count()};
+    }
+
+    [[nodiscard]] RowType operator[](size_t r) noexcept
+    {
+        detail::check_index(r, self().row_count(), "row");
+        return {row_data(r), self().col_count()};
+    }
+
+    // access (might throw)
+
+    [[nodiscard]] ConstRowType at(size_t r) const
+    {
+        check_row(r);
+        return {row_data(r), self().col_count()};
+    }
+
+    [[nodiscard]] RowType at(size_t r)
+    {
+        check_row(r);
+        return {row_data(r), self().col_count()};
+    }
+
+    [[nodiscard]] const T &at(size_t r, size_t c) const { return at(r).at(c); }
+
+    [[nodiscard]] T &at(size_t r, size_t c) { return at(r).at(c); }
+
+    [[nodiscard]] RowRange<const T> rows() const noexcept
+    {
+        return {self().data(), self().row_count(), self().col_count(), self().ld()};
+    }
+
+    [[nodiscard]] RowRange<T> rows() noexcept
+    {
+        return {self().data(), self().row_count(), self().col_count(), self().ld()};
+    }
+
+    /**
+     * @brief view of column c; see \ref Mat::col
+     * @throw std::out_of_range if c >= col_count()
+     */
+    [[nodiscard]] ColView<const T> col(size_t c) const
+    {
+        check_col(c);
+        return {self().data() + c, self().row_count(), static_cast<std::ptrdiff_t>(self().ld())};
+    }
+
+    [[nodiscard]] ColView<T> col(size_t c)
+    {
+        check_col(c);
+        return {self().data() + c, self().row_count(), static_cast<std::ptrdiff_t>(self().ld())};
+    }
+
+    // conversion
+
+    /**
+     * @brief copy into a fixed-size matrix
+     * @tparam S storage policy of the result
+     * @tparam L layout of the result
+     * @throw std::length_error if this matrix is not R x C
+     */
+    template <size_t R, size_t C, typename S = storage::Packed, typename L = layout::RowMajor>
+    [[nodiscard]] Mat<R, C, std::remove_const_t<T>, S, L> to_mat() const
+    {
+        if (self().row_count() != R || self().col_count() != C) throw std::length_error("dimensions do not match");
+        Mat<R, C, std::remove_const_t<T>, S, L> ret;
+        for (size_t r = 0; r < R; ++r) {
+            for (size_t c = 0; c < C; ++c) ret.at(r, c) = row_data(r)[c];
+        }
+        return ret;
+    }
+
+    // operators; the other operand may be a DynMat or a MatMap
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    [[nodiscard]] bool operator==(const X &other) const noexcept
+    {
+        if (self().row_count() != other.row_count() || self().col_count() != other.col_count()) return false;
+        for (size_t r = 0; r < self().row_count(); ++r) {
+            if (!std::equal(row_data(r), row_data(r) + self().col_count(), other.data() + r * other.ld())) return false;
+        }
+        return true;
+    }
+
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    [[nodiscard]] bool operator!=(const X &other) const noexcept
+    {
+        return !this->operator==(other);
+    }
+
+    // element-wise arithmetic; these throw std::length_error if the shapes differ, and other may view some of the
+    // elements of this matrix
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    Derived &operator+=(const X &other)
+    {
+        return accumulate(T{1}, other);
+    }
+
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    Derived &operator-=(const X &other)
+    {
+        return accumulate(T{-1}, other);
+    }
+
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    [[nodiscard]] ResultType operator+(const X &other) const
+    {
+        ResultType ret(self());
+        return ret += other;
+    }
+
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    [[nodiscard]] ResultType operator-(const X &other) const
+    {
+        ResultType ret(self());
+        return ret -= other;
+    }
+
+    // evaluation of lazy expressions (expr.hpp) straight into this matrix; assignment reshapes a DynMat if needed,
+    // everything else throws std::length_error on a shape mismatch
+
+    template <typename Expr, std::enable_if_t<IS_GEMM_EXPR<Expr>, int> = 0>
+    Derived &operator=(const Expr &e)
+    {
+        e.assign_to(self());
+        return self();
+    }
+
+    template <typename Expr, std::enable_if_t<IS_GEMM_EXPR<Expr>, int> = 0>
+    Derived &operator+=(const Expr &e)
+    {
+        e.add_to(self(), T{1});
+        return self();
+    }
+
+    template <typename Expr, std::enable_if_t<IS_GEMM_EXPR<Expr>, int> = 0>
+    Derived &operator-=(const Expr &e)
+    {
+        e.add_to(self(), T{-1});
+        return self();
+    }
+
+    /**
+     * @throw std::length_error if the number of columns of this matrix differs from the number of rows of other
+     */
+    template <typename X, std::enable_if_t<IS_DYN<X>, int> = 0>
+    [[nodiscard]] auto operator*(const X &other) const
+    {
+        if (self().col_count() != other.row_count()) throw std::length_error("inner dimensions must agree");
+        return dyn_product<T, typename X::ElemType>(self().row_count(), other.col_count(), self().col_count(), view(),
+                                                    other.view());
+    }
+
+    template <size_t R, size_t C, typename E, typename S, typename L>
+    [[nodiscard]] auto operator*(const Mat<R, C, E, S, L> &other) const
+    {
+        if constexpr (!Mat<R, C, E, S, L>::LayoutMap::STRIDED) {
+            return *this * Mat<R, C, std::remove_const_t<E>, typename S::Result>(other);
+        } else {
+            if (self().col_count() != R) throw std::length_error("inner dimensions must agree");
+            return dyn_product<T, E>(self().row_count(), C, self().col_count(), view(), other.view());
+        }
+    }
+
+    /**
+     * @return return the transpose of this matrix by value
+     */
+    [[nodiscard]] ResultType transpose() const
+    {
+        ResultType ret(self().col_count(), self().row_count());
+        engine::blocked_transpose(self().row_count(), self().col_count(), self().data(), self().ld(), ret.data(),
+                                  ret.ld());
+        return ret;
+    }
+
+    /**
+     * @return a zero-copy view of the transpose of this matrix; see \ref Mat::transpose_view
+     */
+    [[nodiscard]] TransposeView<Derived> transpose_view() const & noexcept { return TransposeView<Derived>{self()}; }
+
+    TransposeView<Derived> transpose_view() const && = delete;  ///< the view would dangle
+
+    /**
+     * @brief br x bc view of the block whose top-left element is (r0, c0), aliasing the elements of this matrix; see
+     * \ref Mat::block
+     * @throw std::out_of_range if the block does not fit in this matrix
+     */
+    [[nodiscard]] MatMap<T> block(size_t r0, size_t c0, size_t br, size_t bc)
+    {
+        check_block(self().row_count(), self().col_count(), r0, c0, br, bc);
+        return {row_data(r0) + c0, br, bc, self().ld()};
+    }
+
+    [[nodiscard]] MatMap<const T> block(size_t r0, size_t c0, size_t br, size_t bc) const
+    {
+        check_block(self().row_count(), self().col_count(), r0, c0, br, bc);
+        return {row_data(r0) + c0, br, bc, self().ld()};
+    }
+
+    /**
+     * @return this matrix as a strided operand of the gemm engine
+     */
+    [[nodiscard]] engine::StridedView<const T> view() const noexcept
+    {
+        return {self().data(), static_cast<std::ptrdiff_t>(self().ld()), 1};
+    }
+
+    [[nodiscard]] engine::StridedView<T> view() noexcept
+    {
+        return {self().data(), static_cast<std::ptrdiff_t>(self().ld()), 1};
+    }
+
+   protected:
+    [[nodiscard]] const Derived &self() const noexcept { return static_cast<const Derived &>(*this); }
+
+    [[nodiscard]] Derived &self() noexcept { return static_cast<Derived &>(*this); }
+
+    [[nodiscard]] T *row_data(size_t r) noexcept { return self().data() + r * self().ld(); }
+
+    [[nodiscard]] const T *row_data(size_t r) const noexcept { return self().data() + r * self().ld(); }
+
+    void check_row(size_t r) const
+    {
+        if (r >= self().row_count()) throw std::out_of_range("row index out of range");
+    }
+
+    void check_col(size_t c) const
+    {
+        if (c >= self().col_count()) throw std::out_of_range("column index out of range");
+    }
+
+    template <typename X>
+    void check_same_shape(const X &other) const
+    {
+        if (self().row_count() != other.row_count() || self().col_count() != other.col_count()) {
+            throw std::length_error("dimensions do not match");
+        }
+    }
+
+    /**
+     * @return whether other views some of the elements of this matrix at other positions, so that writing this
+     * matrix row by row would change elements of other before they are read
+     */
+    template <typename X>
+    [[nodiscard]] bool overlaps(const X &other) const noexcept
+    {
+        if (static_cast<const void *>(other.data()) == static_cast<const void *>(self().data()) &&
+            other.ld() == self().ld()) {
+            return false;
+        }
+        return engine::overlaps(view(), self().row_count(), self().col_count(), other.view(), other.row_count(),
+                                other.col_count());
+    }
+
+   private:
+    template <typename X>
+    Derived &accumulate(T alpha, const X &other)
+    {
+        check_same_shape(other);
+        if (overlaps(other)) return accumulate(alpha, typename X::ResultType(other));
+        engine::axpby(self().row_count(), self().col_count(), alpha, other.view(), T{1}, view());
+        return self();
+    }
+};
+}  // namespace detail
+
+/**
+ * @brief a matrix whose dimensions are only known at runtime
+ * mirrors the accessors of \ref Mat (at, operator[], rows(), transpose(), operator*), but lives on the heap: rows are
+ * stored back to back in one 64-byte aligned buffer and padded to a multiple of 64 bytes, so every row starts on a
+ * cache line and vector loads never straddle two of them
+ * @tparam T the element type
+ */
+template <typename T>
+class DynMat : public detail::DynBase<DynMat<T>, T>
+{
+    using Base = detail::DynBase<DynMat<T>, T>;
+
+   public:
+    using ThisType = DynMat<T>;
+    using typename Base::ConstRowType;
+    using typename Base::ElemType;
+    using typename Base::ResultType;
+    using typename Base::RowType;
+
+    // construction
+
+    /**
+     * @brief an empty 0 x 0 matrix
+     */
+    DynMat() noexcept = default;
+
+    /**
+     * @brief a zero-initialized rows x cols matrix
+     */
+    DynMat(size_t rows, size_t cols) : rows_(rows), cols_(cols), ld_(padded_ld(cols)), elems(rows * ld_) {}
+
+    /**
+     * @brief uniform init: a rows x cols matrix with every element set to value
+     */
+    DynMat(size_t rows, size_t cols, const T &value) : DynMat(rows, cols)
+    {
+        for (auto row : this->rows()) std::fill(row.begin(), row.end(), value);
+    }
+
+    /**
+     * @brief constructor using one initializer_list per row, like the one of \ref Mat
+     * @throw std::length_error if the rows are not all of the same length
+     */
+    DynMat(std::initializer_list<std::initializer_list<T>> l) : DynMat(l.size(), l.size() ? l.begin()->size() : 0)
+    {
+        size_t r = 0;
+        for (const auto &row : l) {
+            if (row.size() != cols_) throw std::length_error("every list must have the same number of elements");
+            std::copy(row.begin(), row.end(), this->row_data(r++));
+        }
+    }
+
+    /**
+     * @brief copy the elements of a fixed-size matrix
+     */
+    template <size_t R, size_t C, typename E, typename S, typename L>
+    explicit DynMat(const Mat<R, C, E, S, L> &m) : DynMat(R, C)
+    {
+        if constexpr (Mat<R, C, E, S, L>::ROW_MAJOR) {
+            for (size_t r = 0; r < R; ++r) std::copy(m[r].begin(), m[r].end(), this->row_data(r));
+        } else {
+            for (size_t r = 0; r < R; ++r) {
+                for (size_t c = 0; c < C; ++c) this->row_data(r)[c] = m.at(r, c);
+            }
+        }
+    }
+
+    /**
+     * @brief copy the elements a view sees
+     */
+    template <typename E, std::enable_if_t<detail::SAME_ELEM<E, T>, int> = 0>
+    explicit DynMat(const MatMap<E> &m) : DynMat(m.row_count(), m.col_count())
+    {
+        for (size_t r = 0; r < rows_; ++r) std::copy(m[r].begin(), m[r].end(), this->row_data(r));
+    }
+
+    /**
+     * @brief evaluate a lazy expression from expr.hpp, e.g. @c DynMat<float> m = alpha * A * B;
+     */
+    template <typename Expr, std::enable_if_t<detail::IS_GEMM_EXPR<Expr>, int> = 0>
+    DynMat(const Expr &e)  // NOLINT: implicit on purpose
+    {
+        e.assign_to(*this);
+    }
+
+    DynMat(const ThisType &other) : DynMat(other.rows_, other.cols_)
+    {
+        if (ld_ == other.ld_) {
+            std::copy(other.elems.data(), other.elems.data() + rows_ * ld_, elems.data());
+        } else {
+            // other was transposed in place into rows without padding
+            for (size_t r = 0; r < rows_; ++r) {
+                std::copy(other.row_data(r), other.row_data(r) + cols_, this->row_data(r));
+            }
+        }
+    }
+
+    DynMat(ThisType &&other) noexcept
+        : rows_(std::exchange(other.rows_, 0)),
+          cols_(std::exchange(other.cols_, 0)),
+          ld_(std::exchange(other.ld_, 0)),
+          elems(std::move(other.elems))
+    {
+    }
+
+    DynMat &operator=(const ThisType &other)
+    {
+        if (this != &other) *this = ThisType(other);
+        return *this;
+    }
+
+    DynMat &operator=(ThisType &&other) noexcept
+    {
+        std::swap(rows_, other.rows_);
+        std::swap(cols_, other.cols_);
+        std::swap(ld_, other.ld_);
+        elems = std::move(other.elems);
+        return *this;
+    }
+
+    using Base::operator=;  // evaluation of lazy expressions
+
+    ~DynMat() = default;
+
+    // dimensions
+    [[nodiscard]] size_t row_count() const noexcept { return rows_; }
+    [[nodiscard]] size_t col_count() const noexcept { return cols_; }
+
+    /**
+     * @return distance between the starts of two consecutive rows, in elements
+     */
+    [[nodiscard]] size_t ld() const noexcept { return ld_; }
+
+    /**
+     * @return pointer to element (0, 0); row r starts at data() + r * ld()
+     */
+    [[nodiscard]] T *data() noexcept { return elems.data(); }
+
+    [[nodiscard]] const T *data() const noexcept { return elems.data(); }
+
+    /**
+     * @brief this = this^T in the memory this matrix already holds, so the peak footprint is one matrix, not two
+     * a square matrix swaps blocks mirrored across the diagonal through engine::square_transpose_in_place; any other
+     * one changes shape: its rows are packed back to back, the elements follow the cycles of the transposition
+     * permutation (engine::cycle_transpose, a bit of bookkeeping per element) and the new rows spread out again. They
+     * keep their 64-byte padding when the buffer has room for it, and otherwise stay unpadded, i.e. ld() == col_count()
+     */
+    ThisType &transpose_in_place()
+    {
+        if (rows_ == cols_) {
+            engine::square_transpose_in_place(rows_, elems.data(), ld_);
+            return *this;
+        }
+        T *data = elems.data();
+        for (size_t r = 1; r < rows_; ++r) std::move(this->row_data(r), this->row_data(r) + cols_, data + r * cols_);
+        engine::cycle_transpose(rows_, cols_, data);
+        std::swap(rows_, cols_);
+        const size_t padded = padded_ld(cols_);
+        ld_ = rows_ * padded <= elems.size() ? padded : cols_;
+        for (size_t r = rows_; r-- > 1;) {
+            std::move_backward(data + r * cols_, data + (r + 1) * cols_, this->row_data(r) + cols_);
+        }
+        for (size_t r = 0; r < rows_; ++r) std::fill(this->row_data(r) + cols_, this->row_data(r) + ld_, T{});
+        return *this;
+    }
+
+    // special functions
+    static ThisType zeros(size_t rows, size_t cols) { return ThisType(rows, cols); }
+
+    static ThisType identity(size_t n)
+    {
+        ThisType ret(n, n);
+        for (size_t i = 0; i < n; ++i) ret.row_data(i)[i] = T{1};
+        return ret;
+    }
+
+   private:
+    template <typename OT>
+    friend class DynMat;  ///< for ease of interoperability with another instance of this class
+
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t ld_ = 0;
+    // row-major, rows ld_ apart, zero-initialized (padding included); at least rows_ * ld_ elements, more after a
+    // rectangular transpose_in_place
+    engine::AlignedArray<T> elems;
+
+    /**
+     * @return cols rounded up to a whole number of 64-byte lines, when elements tile a line evenly
+     */
+    static constexpr size_t padded_ld(size_t cols) noexcept
+    {
+        constexpr size_t LINE = 64;
+        if constexpr (LINE % sizeof(T) == 0) {
+            return engine::round_up(cols, LINE / sizeof(T));
+        } else {
+            return cols;
+        }
+    }
+};
+
+/**
+ * @brief non-owning rows x cols view of row-major elements owned by someone else, rows ld elements apart
+ * the runtime-sized counterpart of \ref MatRef: the accessors and operators of \ref DynMat over a buffer it does not
+ * own, e.g. one filled by another library, or a block of a larger matrix. Copies view the same elements, while
+ * assignment writes the viewed elements; results of operations are DynMats
+ * @tparam T the element type; const T for a read-only view
+ */
+template <typename T>
+class MatMap : public detail::DynBase<MatMap<T>, T>
+{
+    using Base = detail::DynBase<MatMap<T>, T>;
+
+   public:
+    using ThisType = MatMap<T>;
+    using typename Base::ConstRowType;
+    using typename Base::ElemType;
+    using typename Base::ResultType;
+    using typename Base::RowType;
+
+    // construction
+
+    /**
+     * @param data element (0, 0)
+     * @param ld distance between the starts of two consecutive rows, in elements
+     * @throw std::length_error if rows would overlap
+     */
+    MatMap(T *data, size_t rows, size_t cols, size_t ld) : data_(data), rows_(rows), cols_(cols), ld_(ld)
+    {
+        if (ld < cols && rows > 1) throw std::length_error("rows of a view must not overlap");
+    }
+
+    /**
+     * @brief view rows x cols elements stored back to back
+     */
+    MatMap(T *data, size_t rows, size_t cols) : MatMap(data, rows, cols, cols) {}
+
+    MatMap(const ThisType &) noexcept = default;
+
+    MatMap(ThisType &&) noexcept = default;
+
+    /**
+     * @brief copy the elements of other into the viewed ones
+     * @throw std::length_error if the shapes differ
+     */
+    MatMap &operator=(const ThisType &other)
+    {
+        if (this != &other) assign(other);
+        return *this;
+    }
+
+    MatMap &operator=(ThisType &&other) { return *this = static_cast<const ThisType &>(other); }
+
+    template <typename X, std::enable_if_t<detail::IS_DYN<X> && !std::is_same_v<X, ThisType>, int> = 0>
+    MatMap &operator=(const X &other)
+    {
+        assign(other);
+        return *this;
+    }
+
+    using Base::operator=;  // evaluation of lazy expressions; these throw std::length_error on a shape mismatch
+
+    ~MatMap() = default;
+
+    // dimensions
+    [[nodiscard]] size_t row_count() const noexcept { return rows_; }
+    [[nodiscard]] size_t col_count() const noexcept { return cols_; }
+    [[nodiscard]] size_t ld() const noexcept { return ld_; }
+
+    [[nodiscard]] T *data() noexcept { return data_; }
+
+    [[nodiscard]] const T *data() const noexcept { return data_; }
+
+   private:
+    T *data_;
+    size_t rows_;
+    size_t cols_;
+    size_t ld_;
+
+    /**
+     * @brief copy the elements of other row by row; other may view some of the same elements
+     */
+    template <typename X>
+    void assign(const X &other)
+    {
+        this->check_same_shape(other);
+        if (engine::overlaps(this->view(), rows_, cols_, other.view(), rows_, cols_)) {
+            *this = ResultType(other);
+            return;
+        }
+        for (size_t r = 0; r < rows_; ++r) std::copy(other[r].begin(), other[r].end(), this->row_data(r));
+    }
+};
+
+/**
+ * @brief fixed-size times runtime-sized; the result is runtime-sized
+ * @throw std::length_error if rhs does not have C rows
+ */
+template <size_t R, size_t C, typename T, typename S, typename L, typename X,
+          std::enable_if_t<detail::IS_DYN<X>, int> = 0>
+[[nodiscard]] auto operator*(const Mat<R, C, T, S, L> &lhs, const X &rhs)
+{
+    if constexpr (!Mat<R, C, T, S, L>::LayoutMap::STRIDED) {
+        return Mat<R, C, std::remove_const_t<T>, typename S::Result>(lhs) * rhs;
+    } else {
+        if (rhs.row_count() != C) throw std::length_error("inner dimensions must agree");
+        return detail::dyn_product<T, typename X::ElemType>(R, rhs.col_count(), C, lhs.view(), rhs.view());
+    }
+}
+
+// products with transposed operands; every operand may be a DynMat or a MatMap
+
+/**
+ * @throw std::length_error if the inner dimensions differ
+ */
+template <typename X, typename Y, std::enable_if_t<detail::IS_DYN<X> && detail::IS_DYN<Y>, int> = 0>
+[[nodiscard]] auto operator*(const X &lhs, const TransposeView<Y> &rhs)
+{
+    if (lhs.col_count() != rhs.row_count()) throw std::length_error("inner dimensions must agree");
+    return detail::dyn_product<typename X::ElemType, typename Y::ElemType>(lhs.row_count(), rhs.col_count(),
+                                                                          lhs.col_count(), lhs.view(), rhs.view());
+}
+
+template <typename X, typename Y, std::enable_if_t<detail::IS_DYN<X> && detail::IS_DYN<Y>, int> = 0>
+[[nodiscard]] auto operator*(const TransposeView<X> &lhs, const Y &rhs)
+{
+    if (lhs.col_count() != rhs.row_count()) throw std::length_error("inner dimensions must agree");
+    return detail::dyn_product<typename X::ElemType, typename Y::ElemType>(lhs.row_count(), rhs.col_count(),
+                                                                          lhs.col_count(), lhs.view(), rhs.view());
+}
+
+template <typename X, typename Y, std::enable_if_t<detail::IS_DYN<X> && detail::IS_DYN<Y>, int> = 0>
+[[nodiscard]] auto operator*(const TransposeView<X> &lhs, const TransposeView<Y> &rhs)
+{
+    if (lhs.col_count() != rhs.row_count()) throw std::length_error("inner dimensions must agree");
+    return detail::dyn_product<typename X::ElemType, typename Y::ElemType>(lhs.row_count(), rhs.col_count(),
+                                                                          lhs.col_count(), lhs.view(), rhs.view());
+}
+
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_DYN_MATRIX_HPP
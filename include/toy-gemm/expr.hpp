@@ -0,0 +1,408 @@
+#ifndef TOY_GEMM_EXPR_HPP
+#define TOY_GEMM_EXPR_HPP
+
+#include <complex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "dyn_matrix.hpp"
+#include "gemm.hpp"
+#include "matrix.hpp"
+
+/**
+ * Expression templates for BLAS-style updates. Scaling a matrix by a scalar does not compute anything; it yields a
+ * Scaled expression, which multiplied by another matrix yields a Product, which plus another (scaled) matrix yields a
+ * Gemm. Assigning one of these to a matrix, or accumulating it with += / -=, runs the gemm engine once, straight into
+ * the storage of that matrix:
+ * @code
+ * C = alpha * A * B + beta * C;  // one pass, no temporaries
+ * C += prod(A, B);               // A * B alone is evaluated eagerly by Mat::operator*, prod() is its lazy spelling
+ * C -= 2 * A.transpose_view() * B;
+ * @endcode
+ * Expressions refer to their operands, so like \ref TransposeView they must not outlive them; don't store them in auto
+ * variables. Scalars convert to the element type of the matrix the expression is evaluated into, and integral element
+ * types only take integral scalars: @c C = 0.5 * A * B into an int C does not compile.
+ */
+
+namespace toy_gemm
+{
+namespace detail
+{
+template <typename S>
+constexpr bool IS_SCALAR = std::is_arithmetic_v<S>;
+
+template <typename S>
+constexpr bool IS_SCALAR<std::complex<S>> = true;
+
+/**
+ * @brief whether a scalar of type S scales elements of type U without truncating it: integral elements only take
+ * integral scalars, so that e.g. 0.5 * A into an int matrix is a compile error rather than a scaling by 0
+ */
+template <typename S, typename U>
+constexpr bool SCALES_EXACTLY = !std::is_integral_v<U> || std::is_integral_v<S>;
+
+/**
+ * @return s as a U, for a scalar of an expression evaluated into a matrix of U
+ */
+template <typename U, typename S>
+[[nodiscard]] constexpr U scalar_as(S s) noexcept
+{
+    static_assert(SCALES_EXACTLY<S, U>, "an integral element type would truncate this scalar");
+    return static_cast<U>(s);
+}
+
+/**
+ * @brief matrices and views that expressions can be built from; each has row_count(), col_count() and view()
+ */
+template <typename X>
+constexpr bool IS_OPERAND = false;
+
+template <size_t R, size_t C, typename T, typename S, typename L>
+constexpr bool IS_OPERAND<Mat<R, C, T, S, L>> = Mat<R, C, T, S, L>::LayoutMap::STRIDED;  ///< tiled ones have no view
+
+template <typename T>
+constexpr bool IS_OPERAND<DynMat<T>> = true;
+
+template <typename T>
+constexpr bool IS_OPERAND<MatMap<T>> = true;
+
+template <typename M>
+constexpr bool IS_OPERAND<TransposeView<M>> = true;
+
+template <typename X>
+constexpr bool IS_DYN_MAT = false;
+
+template <typename T>
+constexpr bool IS_DYN_MAT<DynMat<T>> = true;
+
+/**
+ * @brief make sure out is rows x cols; a DynMat gets reshaped, a Mat or a view has to match already
+ */
+template <typename Out>
+void prepare_output(Out &out, size_t rows, size_t cols)
+{
+    if (out.row_count() == rows && out.col_count() == cols) return;
+    if constexpr (IS_DYN_MAT<Out>) {
+        out = Out(rows, cols);
+    } else {
+        throw std::length_error("dimensions do not match");
+    }
+}
+
+template <typename Out>
+void check_output(const Out &out, size_t rows, size_t cols)
+{
+    if (out.row_count() != rows || out.col_count() != cols) throw std::length_error("dimensions do not match");
+}
+
+/**
+ * @return whether evaluating into out would overwrite elements of operand x before they are read
+ */
+template <typename Out, typename X>
+[[nodiscard]] bool aliases(Out &out, const X &x) noexcept
+{
+    return engine::overlaps(out.view(), out.row_count(), out.col_count(), x.view(), x.row_count(), x.col_count());
+}
+
+/**
+ * @return whether x reads exactly the elements of out, at the same positions
+ */
+template <typename Out, typename X>
+[[nodiscard]] bool same_view(Out &out, const X &x) noexcept
+{
+    const auto o = out.view();
+    const auto v = x.view();
+    return static_cast<const void *>(o.data) == static_cast<const void *>(v.data) && o.row_stride == v.row_stride &&
+           o.col_stride == v.col_stride;
+}
+}  // namespace detail
+
+/**
+ * @brief alpha * X
+ */
+template <typename X, typename S>
+class Scaled
+{
+   public:
+    using GemmExprTag = void;
+
+    constexpr Scaled(S alpha, const X &x) noexcept : alpha_(alpha), x_(&x) {}
+
+    [[nodiscard]] constexpr S alpha() const noexcept { return alpha_; }
+    [[nodiscard]] constexpr const X &operand() const noexcept { return *x_; }
+    [[nodiscard]] size_t row_count() const noexcept { return x_->row_count(); }
+    [[nodiscard]] size_t col_count() const noexcept { return x_->col_count(); }
+
+    template <typename Out>
+    void assign_to(Out &out) const
+    {
+        using U = typename Out::ElemType;
+        if (!detail::same_view(out, *x_) && detail::aliases(out, *x_)) {
+            // e.g. A = 2 * A.transpose_view()
+            typename Out::ResultType tmp(*this);
+            out = std::move(tmp);
+            return;
+        }
+        detail::prepare_output(out, row_count(), col_count());
+        engine::axpby(row_count(), col_count(), detail::scalar_as<U>(alpha_), x_->view(), U{}, out.view());
+    }
+
+    template <typename Out>
+    void add_to(Out &out, typename Out::ElemType sign) const
+    {
+        using U = typename Out::ElemType;
+        detail::check_output(out, row_count(), col_count());
+        if (!detail::same_view(out, *x_) && detail::aliases(out, *x_)) {
+            // e.g. A += 2 * A.transpose_view()
+            typename Out::ResultType tmp(*this);
+            engine::axpby(row_count(), col_count(), sign, tmp.view(), U{1}, out.view());
+            return;
+        }
+        engine::axpby(row_count(), col_count(), sign * detail::scalar_as<U>(alpha_), x_->view(), U{1}, out.view());
+    }
+
+   private:
+    S alpha_;
+    const X *x_;
+};
+
+/**
+ * @brief alpha * X * Y
+ */
+template <typename X, typename Y, typename S>
+class Product
+{
+   public:
+    using GemmExprTag = void;
+
+    constexpr Product(S alpha, const X &x, const Y &y) noexcept : alpha_(alpha), x_(&x), y_(&y) {}
+
+    [[nodiscard]] constexpr S alpha() const noexcept { return alpha_; }
+    [[nodiscard]] constexpr const X &lhs() const noexcept { return *x_; }
+    [[nodiscard]] constexpr const Y &rhs() const noexcept { return *y_; }
+    [[nodiscard]] size_t row_count() const noexcept { return x_->row_count(); }
+    [[nodiscard]] size_t col_count() const noexcept { return y_->col_count(); }
+
+    /**
+     * @throw std::length_error if the inner dimensions differ
+     */
+    void check_shape() const
+    {
+        if (x_->col_count() != y_->row_count()) throw std::length_error("inner dimensions must agree");
+    }
+
+    /**
+     * @return whether writing out would overwrite elements of X or Y
+     */
+    template <typename Out>
+    [[nodiscard]] bool aliases(Out &out) const noexcept
+    {
+        return detail::aliases(out, *x_) || detail::aliases(out, *y_);
+    }
+
+    /**
+     * @brief out := alpha * X * Y * scale + beta * out
+     * @note out must already have the right shape
+     */
+    template <typename Out>
+    void gemm_into(Out &out, typename Out::ElemType scale, typename Out::ElemType beta) const
+    {
+        using U = typename Out::ElemType;
+        const U alpha = scale * detail::scalar_as<U>(alpha_);
+        if (aliases(out)) {
+            // the engine reads X and Y while writing out, so go through a temporary
+            typename Out::ResultType tmp(out);
+            engine::gemm(row_count(), col_count(), x_->col_count(), alpha, x_->view(), y_->view(), beta, tmp.view());
+            out = std::move(tmp);
+            return;
+        }
+        engine::gemm(row_count(), col_count(), x_->col_count(), alpha, x_->view(), y_->view(), beta, out.view());
+    }
+
+    template <typename Out>
+    void assign_to(Out &out) const
+    {
+        using U = typename Out::ElemType;
+        check_shape();
+        if (aliases(out)) {
+            // e.g. A = 2 * A * B; reshaping a DynMat output first would lose A
+            typename Out::ResultType tmp(*this);
+            out = std::move(tmp);
+            return;
+        }
+        detail::prepare_output(out, row_count(), col_count());
+        gemm_into(out, U{1}, U{});
+    }
+
+    template <typename Out>
+    void add_to(Out &out, typename Out::ElemType sign) const
+    {
+        using U = typename Out::ElemType;
+        check_shape();
+        detail::check_output(out, row_count(), col_count());
+        gemm_into(out, sign, U{1});
+    }
+
+   private:
+    S alpha_;
+    const X *x_;
+    const Y *y_;
+};
+
+/**
+ * @brief alpha * X * Y + beta * Z
+ */
+template <typename X, typename Y, typename S, typename Z, typename SZ>
+class Gemm
+{
+   public:
+    using GemmExprTag = void;
+
+    constexpr Gemm(const Product<X, Y, S> &p, SZ beta, const Z &z) noexcept : p_(p), beta_(beta), z_(&z) {}
+
+    [[nodiscard]] size_t row_count() const noexcept { return p_.row_count(); }
+    [[nodiscard]] size_t col_count() const noexcept { return p_.col_count(); }
+
+    template <typename Out>
+    void assign_to(Out &out) const
+    {
+        using U = typename Out::ElemType;
+        check_shape();
+        if (detail::same_view(out, *z_)) {
+            // C = alpha * A * B + beta * C: scale C in place while accumulating into it
+            p_.gemm_into(out, U{1}, detail::scalar_as<U>(beta_));
+            return;
+        }
+        if (detail::aliases(out, *z_) || p_.aliases(out)) {
+            // writing beta * Z into out would overwrite an operand that is still to be read
+            typename Out::ResultType tmp(Scaled<Z, SZ>(beta_, *z_));
+            p_.gemm_into(tmp, U{1}, U{1});
+            out = std::move(tmp);
+            return;
+        }
+        detail::prepare_output(out, row_count(), col_count());
+        engine::axpby(row_count(), col_count(), detail::scalar_as<U>(beta_), z_->view(), U{}, out.view());
+        p_.gemm_into(out, U{1}, U{1});
+    }
+
+    template <typename Out>
+    void add_to(Out &out, typename Out::ElemType sign) const
+    {
+        using U = typename Out::ElemType;
+        check_shape();
+        detail::check_output(out, row_count(), col_count());
+        if (detail::same_view(out, *z_)) {
+            // C += alpha * A * B + beta * C
+            p_.gemm_into(out, sign, U{1} + sign * detail::scalar_as<U>(beta_));
+            return;
+        }
+        if (detail::aliases(out, *z_) || p_.aliases(out)) {
+            typename Out::ResultType tmp(*this);
+            engine::axpby(row_count(), col_count(), sign, tmp.view(), U{1}, out.view());
+            return;
+        }
+        engine::axpby(row_count(), col_count(), sign * detail::scalar_as<U>(beta_), z_->view(), U{1}, out.view());
+        p_.gemm_into(out, sign, U{1});
+    }
+
+   private:
+    Product<X, Y, S> p_;
+    SZ beta_;
+    const Z *z_;
+
+    void check_shape() const
+    {
+        p_.check_shape();
+        if (z_->row_count() != row_count() || z_->col_count() != col_count()) {
+            throw std::length_error("dimensions do not match");
+        }
+    }
+};
+
+// building expressions
+
+template <typename S, typename X, std::enable_if_t<detail::IS_SCALAR<S> && detail::IS_OPERAND<X>, int> = 0>
+[[nodiscard]] constexpr Scaled<X, S> operator*(S alpha, const X &x) noexcept
+{
+    return {alpha, x};
+}
+
+template <typename X, typename S, std::enable_if_t<detail::IS_SCALAR<S> && detail::IS_OPERAND<X>, int> = 0>
+[[nodiscard]] constexpr Scaled<X, S> operator*(const X &x, S alpha) noexcept
+{
+    return {alpha, x};
+}
+
+template <typename X, typename S, typename Y, std::enable_if_t<detail::IS_OPERAND<Y>, int> = 0>
+[[nodiscard]] constexpr Product<X, Y, S> operator*(const Scaled<X, S> &x, const Y &y) noexcept
+{
+    return {x.alpha(), x.operand(), y};
+}
+
+template <typename X, typename Y, typename S, std::enable_if_t<detail::IS_OPERAND<X>, int> = 0>
+[[nodiscard]] constexpr Product<X, Y, S> operator*(const X &x, const Scaled<Y, S> &y) noexcept
+{
+    return {y.alpha(), x, y.operand()};
+}
+
+/**
+ * @brief the lazy spelling of X * Y, for @c C += prod(A, B) and friends
+ */
+template <typename X, typename Y, std::enable_if_t<detail::IS_OPERAND<X> && detail::IS_OPERAND<Y>, int> = 0>
+[[nodiscard]] constexpr Product<X, Y, int> prod(const X &x, const Y &y) noexcept
+{
+    return {1, x, y};
+}
+
+template <typename X, typename Y, typename S, typename Z, typename SZ>
+[[nodiscard]] constexpr Gemm<X, Y, S, Z, SZ> operator+(const Product<X, Y, S> &p, const Scaled<Z, SZ> &z) noexcept
+{
+    return {p, z.alpha(), z.operand()};
+}
+
+template <typename X, typename Y, typename S, typename Z, typename SZ>
+[[nodiscard]] constexpr Gemm<X, Y, S, Z, SZ> operator+(const Scaled<Z, SZ> &z, const Product<X, Y, S> &p) noexcept
+{
+    return {p, z.alpha(), z.operand()};
+}
+
+template <typename X, typename Y, typename S, typename Z, typename SZ>
+[[nodiscard]] constexpr Gemm<X, Y, S, Z, SZ> operator-(const Product<X, Y, S> &p, const Scaled<Z, SZ> &z) noexcept
+{
+    return {p, -z.alpha(), z.operand()};
+}
+
+template <typename X, typename Y, typename S, typename Z, std::enable_if_t<detail::IS_OPERAND<Z>, int> = 0>
+[[nodiscard]] constexpr Gemm<X, Y, S, Z, int> operator+(const Product<X, Y, S> &p, const Z &z) noexcept
+{
+    return {p, 1, z};
+}
+
+template <typename X, typename Y, typename S, typename Z, std::enable_if_t<detail::IS_OPERAND<Z>, int> = 0>
+[[nodiscard]] constexpr Gemm<X, Y, S, Z, int> operator+(const Z &z, const Product<X, Y, S> &p) noexcept
+{
+    return {p, 1, z};
+}
+
+template <typename X, typename Y, typename S, typename Z, std::enable_if_t<detail::IS_OPERAND<Z>, int> = 0>
+[[nodiscard]] constexpr Gemm<X, Y, S, Z, int> operator-(const Product<X, Y, S> &p, const Z &z) noexcept
+{
+    return {p, -1, z};
+}
+
+/**
+ * @brief BLAS-style C := alpha * A * B + beta * C, i.e. @c C = alpha * A * B + beta * C spelled as a function call
+ * large products run on the thread pool of thread_pool.hpp, see parallel::set_num_threads
+ * @throw std::length_error if the shapes of A, B and C don't agree
+ */
+template <typename S, typename X, typename Y, typename Out,
+          std::enable_if_t<detail::IS_SCALAR<S> && detail::IS_OPERAND<X> && detail::IS_OPERAND<Y>, int> = 0>
+void gemm(S alpha, const X &a, const Y &b, S beta, Out &c)
+{
+    c = Gemm<X, Y, S, Out, S>(Product<X, Y, S>(alpha, a, b), beta, c);
+}
+
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_EXPR_HPP
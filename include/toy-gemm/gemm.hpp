@@ -0,0 +1,679 @@
+#ifndef TOY_GEMM_GEMM_HPP
+#define TOY_GEMM_GEMM_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "kernels.hpp"
+#include "layout.hpp"
+#include "thread_pool.hpp"
+
+namespace toy_gemm
+{
+namespace engine
+{
+/**
+ * @brief non-owning view of a 2D array with arbitrary row and column strides, both counted in elements
+ * a row-major buffer with leading dimension ld is {data, ld, 1}; its transpose is {data, 1, ld}
+ */
+template <typename T>
+struct StridedView {
+    T *data;
+    std::ptrdiff_t row_stride;
+    std::ptrdiff_t col_stride;
+
+    [[nodiscard]] constexpr T &operator()(size_t r, size_t c) const noexcept
+    {
+        return data[static_cast<std::ptrdiff_t>(r) * row_stride + static_cast<std::ptrdiff_t>(c) * col_stride];
+    }
+};
+
+/**
+ * @brief cache blocking parameters, in elements
+ * KC * NR elements of B stay in L1 while a microkernel runs, MC * KC elements of packed A stay in L2 and KC * NC
+ * elements of packed B stay in L3
+ */
+struct BlockSizes {
+    size_t mc;
+    size_t kc;
+    size_t nc;
+};
+
+template <typename T>
+[[nodiscard]] constexpr BlockSizes block_sizes(size_t mr, size_t nr) noexcept
+{
+    constexpr size_t L1 = 32 * 1024;
+    constexpr size_t L2 = 256 * 1024;
+    constexpr size_t L3 = 4 * 1024 * 1024;
+    const size_t kc = std::max<size_t>(L1 / 2 / (nr * sizeof(T)), 16);
+    const size_t mc = std::max<size_t>(L2 / 2 / (kc * sizeof(T)) / mr, 1) * mr;
+    const size_t nc = std::max<size_t>(L3 / 2 / (kc * sizeof(T)) / nr, 1) * nr;
+    return {mc, kc, nc};
+}
+
+[[nodiscard]] constexpr size_t round_up(size_t x, size_t multiple) noexcept
+{
+    return (x + multiple - 1) / multiple * multiple;
+}
+
+/**
+ * @brief heap array of T aligned for vector loads; the elements of a DynMat live in one of these
+ */
+template <typename T>
+class AlignedArray
+{
+   public:
+    constexpr static size_t ALIGNMENT = std::max<size_t>(64, alignof(T));
+
+    AlignedArray() noexcept = default;
+
+    explicit AlignedArray(size_t n)
+        : n_(n), data_(static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{ALIGNMENT})))
+    {
+        std::uninitialized_value_construct_n(data_, n_);
+    }
+
+    AlignedArray(const AlignedArray &) = delete;
+    AlignedArray &operator=(const AlignedArray &) = delete;
+
+    AlignedArray(AlignedArray &&other) noexcept
+        : n_(std::exchange(other.n_, 0)), data_(std::exchange(other.data_, nullptr))
+    {
+    }
+
+    AlignedArray &operator=(AlignedArray &&other) noexcept
+    {
+        std::swap(n_, other.n_);
+        std::swap(data_, other.data_);
+        return *this;
+    }
+
+    ~AlignedArray()
+    {
+        std::destroy_n(data_, n_);
+        ::operator delete(data_, std::align_val_t{ALIGNMENT});
+    }
+
+    [[nodiscard]] T *data() noexcept { return data_; }
+    [[nodiscard]] const T *data() const noexcept { return data_; }
+    [[nodiscard]] size_t size() const noexcept { return n_; }
+
+   private:
+    size_t n_ = 0;
+    T *data_ = nullptr;
+};
+
+/**
+ * @brief copy an mc x kc block of A into slivers of mr rows, each stored column by column
+ * rows past mc are zero-filled so the microkernel can always compute a full tile
+ * @note elements are converted to T while packing, so A may hold any type convertible to T
+ */
+template <typename T, typename AView>
+void pack_a(size_t mc, size_t kc, const AView &a, size_t r0, size_t c0, size_t mr, T *dst)
+{
+    for (size_t i0 = 0; i0 < mc; i0 += mr) {
+        const size_t rows = std::min(mr, mc - i0);
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t i = 0; i < rows; ++i) *dst++ = static_cast<T>(a(r0 + i0 + i, c0 + p));
+            for (size_t i = rows; i < mr; ++i) *dst++ = T{};
+        }
+    }
+}
+
+/**
+ * @brief copy a kc x nc block of B into slivers of nr columns, each stored row by row
+ * columns past nc are zero-filled so the microkernel can always compute a full tile
+ */
+template <typename T, typename BView>
+void pack_b(size_t kc, size_t nc, const BView &b, size_t r0, size_t c0, size_t nr, T *dst)
+{
+    for (size_t j0 = 0; j0 < nc; j0 += nr) {
+        const size_t cols = std::min(nr, nc - j0);
+        for (size_t p = 0; p < kc; ++p) {
+            for (size_t j = 0; j < cols; ++j) *dst++ = static_cast<T>(b(r0 + p, c0 + j0 + j));
+            for (size_t j = cols; j < nr; ++j) *dst++ = T{};
+        }
+    }
+}
+
+/**
+ * @brief multiply a packed mc x kc block of A with a packed kc x nc block of B into C, one microkernel call per tile
+ * tiles hanging over the edge of C are computed into a scratch tile and then merged into C
+ */
+template <typename T>
+void macro_kernel(size_t mc, size_t nc, size_t kc, T alpha, const T *a_pack, const T *b_pack, T beta,
+                  const StridedView<T> &c, const MicroKernel<T> &kernel)
+{
+    const size_t mr = kernel.mr;
+    const size_t nr = kernel.nr;
+    T scratch[MAX_KERNEL_TILE];
+    for (size_t j0 = 0; j0 < nc; j0 += nr) {
+        const size_t cols = std::min(nr, nc - j0);
+        for (size_t i0 = 0; i0 < mc; i0 += mr) {
+            const size_t rows = std::min(mr, mc - i0);
+            const T *a = a_pack + i0 * kc;
+            const T *b = b_pack + j0 * kc;
+            if (rows == mr && cols == nr) {
+                kernel.fn(kc, a, b, &c(i0, j0), c.row_stride, c.col_stride, alpha, beta);
+                continue;
+            }
+            kernel.fn(kc, a, b, scratch, static_cast<std::ptrdiff_t>(nr), 1, alpha, T{});
+            const bool overwrite = beta == T{};
+            for (size_t i = 0; i < rows; ++i) {
+                for (size_t j = 0; j < cols; ++j) {
+                    T &dst = c(i0 + i, j0 + j);
+                    dst = overwrite ? scratch[i * nr + j] : scratch[i * nr + j] + beta * dst;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Y := alpha * X + beta * Y over m x n elements; beta == 0 overwrites Y without reading it
+ * @note X and Y may be the same view, but must not overlap otherwise
+ */
+template <typename T, typename XView>
+void axpby(size_t m, size_t n, T alpha, const XView &x, T beta, const StridedView<T> &y)
+{
+    const bool overwrite = beta == T{};
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            T &dst = y(i, j);
+            const T src = static_cast<T>(x(i, j));
+            dst = overwrite ? alpha * src : alpha * src + beta * dst;
+        }
+    }
+}
+
+/**
+ * @brief whether two m x n strided views touch any common memory (conservatively: whether their address ranges
+ * intersect)
+ */
+template <typename T, typename E>
+[[nodiscard]] bool overlaps(const StridedView<T> &a, size_t a_rows, size_t a_cols, const StridedView<E> &b,
+                            size_t b_rows, size_t b_cols) noexcept
+{
+    if (a_rows == 0 || a_cols == 0 || b_rows == 0 || b_cols == 0) return false;
+    const auto range = [](const auto &v, size_t rows, size_t cols) {
+        const auto *first = reinterpret_cast<const char *>(&v(0, 0));
+        const auto *last = reinterpret_cast<const char *>(&v(rows - 1, cols - 1));
+        const auto *corner_r = reinterpret_cast<const char *>(&v(rows - 1, 0));
+        const auto *corner_c = reinterpret_cast<const char *>(&v(0, cols - 1));
+        const auto lo = std::min({first, last, corner_r, corner_c});
+        const auto hi = std::max({first, last, corner_r, corner_c}) + sizeof(v(0, 0));
+        return std::make_pair(lo, hi);
+    };
+    const auto [a_lo, a_hi] = range(a, a_rows, a_cols);
+    const auto [b_lo, b_hi] = range(b, b_rows, b_cols);
+    return std::less<>{}(a_lo, b_hi) && std::less<>{}(b_lo, a_hi);
+}
+
+/**
+ * @brief scale every element of an m x n C by beta; beta == 0 clears C without reading it
+ */
+template <typename T>
+void scale(size_t m, size_t n, T beta, const StridedView<T> &c)
+{
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            T &dst = c(i, j);
+            dst = beta == T{} ? T{} : beta * dst;
+        }
+    }
+}
+
+/**
+ * @brief plain triple loop for products too small to amortize packing
+ */
+template <typename T, typename AView, typename BView>
+void small_gemm(size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta, const StridedView<T> &c)
+{
+    const bool overwrite = beta == T{};
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            T acc{};
+            for (size_t p = 0; p < k; ++p) acc += static_cast<T>(a(i, p)) * static_cast<T>(b(p, j));
+            T &dst = c(i, j);
+            dst = overwrite ? alpha * acc : alpha * acc + beta * dst;
+        }
+    }
+}
+
+constexpr size_t SMALL_GEMM_VOLUME = 16 * 16 * 16;  ///< m * n * k at or below which \ref gemm skips packing
+constexpr size_t PARALLEL_GEMM_VOLUME = 64 * 64 * 64;  ///< m * n * k from which \ref gemm uses the thread pool
+constexpr size_t TILES_PER_THREAD = 8;  ///< parallel products cut C into at least this many tiles per thread
+
+/**
+ * @brief the five-loop nest of \ref gemm over the m x n block of C at (i0, j0), on the calling thread
+ */
+template <typename T, typename AView, typename BView>
+void gemm_block(size_t i0, size_t j0, size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta,
+                const StridedView<T> &c, const MicroKernel<T> &kernel)
+{
+    const BlockSizes bs = block_sizes<T>(kernel.mr, kernel.nr);
+    const size_t kc_max = std::min(bs.kc, k);
+    // from the arena of this thread, which keeps them for the next block or product
+    arena::Buffer<T> a_pack(std::min(bs.mc, round_up(m, kernel.mr)) * kc_max);
+    arena::Buffer<T> b_pack(std::min(bs.nc, round_up(n, kernel.nr)) * kc_max);
+
+    for (size_t jc = 0; jc < n; jc += bs.nc) {
+        const size_t nc = std::min(bs.nc, n - jc);
+        for (size_t pc = 0; pc < k; pc += bs.kc) {
+            const size_t kc = std::min(bs.kc, k - pc);
+            pack_b(kc, nc, b, pc, j0 + jc, kernel.nr, b_pack.data());
+            // C only gets scaled by beta once, the following panels accumulate
+            const T beta_p = pc == 0 ? beta : T{1};
+            for (size_t ic = 0; ic < m; ic += bs.mc) {
+                const size_t mc = std::min(bs.mc, m - ic);
+                pack_a(mc, kc, a, i0 + ic, pc, kernel.mr, a_pack.data());
+                const StridedView<T> c_block{&c(i0 + ic, j0 + jc), c.row_stride, c.col_stride};
+                macro_kernel(mc, nc, kc, alpha, a_pack.data(), b_pack.data(), beta_p, c_block, kernel);
+            }
+        }
+    }
+}
+
+/**
+ * @brief how C is cut into tiles for a parallel product; tiles are multiples of the microkernel tile, except at the
+ * bottom and right edges
+ */
+struct TileGrid {
+    size_t tile_m;
+    size_t tile_n;
+    size_t rows;  ///< number of tiles down the rows of C
+    size_t cols;  ///< number of tiles across the columns of C
+
+    [[nodiscard]] constexpr size_t count() const noexcept { return rows * cols; }
+};
+
+/**
+ * @brief cut an m x n C into at least @p tasks tiles where possible, halving the longer side of the tile each time
+ * tiles are never taller than @p mc, so each one is a run of macro kernels over a single packed block of A
+ */
+[[nodiscard]] constexpr TileGrid tile_grid(size_t m, size_t n, size_t mr, size_t nr, size_t mc, size_t tasks) noexcept
+{
+    size_t tile_m = std::min(round_up(m, mr), mc);
+    size_t tile_n = round_up(n, nr);
+    const auto count = [&] { return ((m + tile_m - 1) / tile_m) * ((n + tile_n - 1) / tile_n); };
+    while (count() < tasks) {
+        const bool split_m = tile_m > mr && (tile_m >= tile_n || tile_n <= nr);
+        if (split_m) {
+            tile_m = round_up(tile_m / 2, mr);
+        } else if (tile_n > nr) {
+            tile_n = round_up(tile_n / 2, nr);
+        } else {
+            break;
+        }
+    }
+    return {tile_m, tile_n, (m + tile_m - 1) / tile_m, (n + tile_n - 1) / tile_n};
+}
+
+/**
+ * @brief the loop nest of \ref gemm on the thread pool, the way BLIS shares packed panels of B
+ * for each (jc, pc), the threads first pack the KC x NC panel of B together, sliver by sliver, into one buffer; then
+ * the band of C under it is cut into tiles, at most MC rows tall, and each tile packs its rows of A and runs the macro
+ * kernel against the shared panel. parallel_for returns once all of its tasks have, which orders each packing before
+ * its use and the next packing after it. A block of A is packed once per tile of its row of tiles, which tile_grid
+ * keeps short by cutting rows before columns
+ */
+template <typename T, typename AView, typename BView>
+void parallel_gemm(size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta,
+                   const StridedView<T> &c, const MicroKernel<T> &kernel, size_t threads)
+{
+    const BlockSizes bs = block_sizes<T>(kernel.mr, kernel.nr);
+    const size_t nr = kernel.nr;
+    arena::Buffer<T> b_pack(std::min(bs.nc, round_up(n, nr)) * std::min(bs.kc, k));
+    for (size_t jc = 0; jc < n; jc += bs.nc) {
+        const size_t nc = std::min(bs.nc, n - jc);
+        const size_t slivers = (nc + nr - 1) / nr;
+        const TileGrid grid = tile_grid(m, nc, kernel.mr, nr, bs.mc, threads * TILES_PER_THREAD);
+        for (size_t pc = 0; pc < k; pc += bs.kc) {
+            const size_t kc = std::min(bs.kc, k - pc);
+            parallel::parallel_for(slivers, [&](size_t s) {
+                const size_t j0 = s * nr;
+                pack_b(kc, std::min(nr, nc - j0), b, pc, jc + j0, nr, b_pack.data() + j0 * kc);
+            });
+            // C only gets scaled by beta once, the following panels accumulate
+            const T beta_p = pc == 0 ? beta : T{1};
+            parallel::parallel_for(grid.count(), [&](size_t t) {
+                const size_t i0 = t / grid.cols * grid.tile_m;
+                const size_t j0 = t % grid.cols * grid.tile_n;
+                const size_t tm = std::min(grid.tile_m, m - i0);
+                const size_t tn = std::min(grid.tile_n, nc - j0);
+                arena::Buffer<T> a_pack(round_up(tm, kernel.mr) * kc);  // from the arena of the thread running it
+                pack_a(tm, kc, a, i0, pc, kernel.mr, a_pack.data());
+                const StridedView<T> c_tile{&c(i0, jc + j0), c.row_stride, c.col_stride};
+                macro_kernel(tm, tn, kc, alpha, a_pack.data(), b_pack.data() + j0 * kc, beta_p, c_tile, kernel);
+            });
+        }
+    }
+}
+
+/**
+ * @brief cache-blocked, packed GEMM: C := alpha * A * B + beta * C
+ * the classic five-loop nest: NC columns of B and C at a time, KC-deep panels of B packed once per (jc, pc), MC rows of
+ * A packed once per (jc, pc, ic), and a register-blocked microkernel over the packed panels.
+ * Products of at least \ref PARALLEL_GEMM_VOLUME run that loop nest on the work-stealing thread pool (see
+ * \ref parallel_gemm and parallel::set_num_threads), each panel of B still packed once; every element of C is still
+ * computed by a single thread, in the same order, so the result does not depend on the number of threads
+ * @tparam T element type of C; A and B are converted to T while packing
+ * @param m rows of A and C
+ * @param n columns of B and C
+ * @param k columns of A, rows of B
+ * @param a anything callable as a(r, c) that yields an element of A, usually a StridedView
+ * @param b anything callable as b(r, c) that yields an element of B, usually a StridedView
+ * @param c view of the output, must not alias A or B
+ */
+template <typename T, typename AView, typename BView>
+void gemm(size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta, const StridedView<T> &c)
+{
+    if (m == 0 || n == 0) return;
+    if (k == 0 || alpha == T{}) {
+        scale(m, n, beta, c);
+        return;
+    }
+    if (m * n * k <= SMALL_GEMM_VOLUME) {
+        small_gemm(m, n, k, alpha, a, b, beta, c);
+        return;
+    }
+
+    const MicroKernel<T> kernel = select_kernel<T>();
+    const size_t threads = parallel::num_threads();
+    if (threads <= 1 || m * n * k < PARALLEL_GEMM_VOLUME) {
+        gemm_block(0, 0, m, n, k, alpha, a, b, beta, c, kernel);
+        return;
+    }
+    parallel_gemm(m, n, k, alpha, a, b, beta, c, kernel, threads);
+}
+
+constexpr size_t TRANSPOSE_TILE = 32;  ///< \ref blocked_transpose moves tiles of this many rows and columns at a time
+
+/**
+ * @brief dst := src^T for an m x n src whose rows are contiguous and ld_src elements apart; dst is n x m with rows
+ * ld_dst elements apart, and must not overlap src
+ * works through TRANSPOSE_TILE x TRANSPOSE_TILE tiles, so the lines of src being read and those of dst being
+ * written stay in L1, and moves each tile as blocks of \ref select_transpose_kernel (8 x 8 for float and int32,
+ * 4 x 4 for double with AVX2), transposed in registers; the ragged edges go element by element
+ */
+template <typename T>
+void blocked_transpose(size_t m, size_t n, const T *src, size_t ld_src, T *dst, size_t ld_dst)
+{
+    const TransposeKernel<T> kernel = select_transpose_kernel<T>();
+    const size_t b = kernel.block;
+    const auto ls = static_cast<std::ptrdiff_t>(ld_src);
+    const auto ld = static_cast<std::ptrdiff_t>(ld_dst);
+    const auto copy = [&](size_t i, size_t j) { dst[j * ld_dst + i] = src[i * ld_src + j]; };
+    for (size_t i0 = 0; i0 < m; i0 += TRANSPOSE_TILE) {
+        const size_t i1 = std::min(i0 + TRANSPOSE_TILE, m);
+        for (size_t j0 = 0; j0 < n; j0 += TRANSPOSE_TILE) {
+            const size_t j1 = std::min(j0 + TRANSPOSE_TILE, n);
+            size_t i = i0;
+            for (; i + b <= i1; i += b) {
+                size_t j = j0;
+                for (; j + b <= j1; j += b) kernel.fn(src + i * ld_src + j, ls, dst + j * ld_dst + i, ld);
+                for (; j < j1; ++j) {
+                    for (size_t r = i; r < i + b; ++r) copy(r, j);
+                }
+            }
+            for (; i < i1; ++i) {
+                for (size_t j = j0; j < j1; ++j) copy(i, j);
+            }
+        }
+    }
+}
+
+/**
+ * @brief transpose the n x n matrix at data, rows ld elements apart, in place
+ * pairs of blocks mirrored across the diagonal are swapped through two small buffers, each block going through the
+ * kernel of \ref select_transpose_kernel, tile by tile as in \ref blocked_transpose; the ragged edge swaps element
+ * by element
+ */
+template <typename T>
+void square_transpose_in_place(size_t n, T *data, size_t ld)
+{
+    const TransposeKernel<T> kernel = select_transpose_kernel<T>();
+    const size_t b = kernel.block;
+    const auto ls = static_cast<std::ptrdiff_t>(ld);
+    const auto lb = static_cast<std::ptrdiff_t>(b);
+    const auto at = [&](size_t i, size_t j) { return data + i * ld + j; };
+    // copy a transposed block out of a buffer, row by row
+    const auto put = [&](const T *block, size_t i, size_t j) {
+        for (size_t r = 0; r < b; ++r) std::copy(block + r * b, block + (r + 1) * b, at(i + r, j));
+    };
+    T upper[MAX_TRANSPOSE_BLOCK * MAX_TRANSPOSE_BLOCK];
+    T lower[MAX_TRANSPOSE_BLOCK * MAX_TRANSPOSE_BLOCK];
+    const size_t whole = n / b * b;
+    for (size_t i0 = 0; i0 < whole; i0 += TRANSPOSE_TILE) {
+        const size_t i1 = std::min(i0 + TRANSPOSE_TILE, whole);
+        for (size_t j0 = i0; j0 < whole; j0 += TRANSPOSE_TILE) {
+            const size_t j1 = std::min(j0 + TRANSPOSE_TILE, whole);
+            for (size_t i = i0; i < i1; i += b) {
+                for (size_t j = std::max(j0, i); j < j1; j += b) {
+                    kernel.fn(at(i, j), ls, upper, lb);
+                    if (i == j) {
+                        put(upper, i, i);
+                        continue;
+                    }
+                    kernel.fn(at(j, i), ls, lower, lb);
+                    put(lower, i, j);
+                    put(upper, j, i);
+                }
+            }
+        }
+    }
+    for (size_t j = whole; j < n; ++j) {
+        for (size_t i = 0; i < j; ++i) std::swap(*at(i, j), *at(j, i));
+    }
+}
+
+/**
+ * @brief transpose the m x n matrix at data, rows back to back, in place into an n x m one, rows back to back
+ * follows the cycles of the permutation that sends element (r, c) to (c, r), moving each element once; a bit per
+ * element marks those already moved, the only memory needed besides the matrix itself
+ */
+template <typename T>
+void cycle_transpose(size_t m, size_t n, T *data)
+{
+    const size_t count = m * n;
+    if (m <= 1 || n <= 1) return;  // the elements are in order already
+    std::vector<bool> moved(count, false);
+    // the first and the last element stay where they are
+    for (size_t start = 1; start + 1 < count; ++start) {
+        if (moved[start]) continue;
+        T carried = std::move(data[start]);
+        size_t from = start;
+        do {
+            const size_t to = from % n * m + from / n;  // (r, c) = (from / n, from % n) goes to (c, r)
+            std::swap(carried, data[to]);
+            moved[to] = true;
+            from = to;
+        } while (from != start);
+    }
+}
+
+/**
+ * @brief geometry of a matrix stored as a grid of contiguous, row-major tiles, the tiles themselves in row-major order
+ * tile (i, j) starts at data + (i * cols + j) * ld
+ */
+template <typename T>
+struct TiledView {
+    T *data;
+    size_t cols;  ///< number of tiles across the columns
+    size_t ld;    ///< elements from the start of one tile to the next; at least tile rows * tile columns
+};
+
+/**
+ * @brief C += A * B for matrices stored as tiles (see layout::Tiled), tile by tile with no packing
+ * the tiles already are the contiguous, cache-sized blocks packing would make; C tiles are tm x tn, A tiles tm x tk
+ * and B tiles tk x tn. Rows of the A and C tiles run whole and so do the columns of the B and C tiles, padding
+ * included, which only feeds the padding of C; the inner dimension stops at k, so the padding of A and B never
+ * reaches an element of C. Rows of tiles of C run on the thread pool for products of at least
+ * \ref PARALLEL_GEMM_VOLUME
+ * @param m_tiles tiles down the rows of A and C
+ * @param k inner dimension, in elements
+ */
+template <typename T, typename TA, typename TB>
+void tiled_gemm(size_t m_tiles, size_t k, size_t tm, size_t tk, size_t tn, const TiledView<const TA> &a,
+                const TiledView<const TB> &b, const TiledView<T> &c)
+{
+    const size_t k_tiles = (k + tk - 1) / tk;
+    const auto tile_row = [&](size_t ti) {
+        for (size_t tj = 0; tj < c.cols; ++tj) {
+            T *out = c.data + (ti * c.cols + tj) * c.ld;
+            for (size_t tp = 0; tp < k_tiles; ++tp) {
+                const TA *in_a = a.data + (ti * a.cols + tp) * a.ld;
+                const TB *in_b = b.data + (tp * b.cols + tj) * b.ld;
+                const size_t depth = std::min(tk, k - tp * tk);
+                for (size_t i = 0; i < tm; ++i) {
+                    for (size_t p = 0; p < depth; ++p) {
+                        const T x = static_cast<T>(in_a[i * tk + p]);
+                        const TB *row_b = in_b + p * tn;
+                        T *row_c = out + i * tn;
+                        for (size_t j = 0; j < tn; ++j) row_c[j] += x * static_cast<T>(row_b[j]);
+                    }
+                }
+            }
+        }
+    };
+    if (parallel::num_threads() <= 1 || m_tiles * tm * c.cols * tn * k < PARALLEL_GEMM_VOLUME) {
+        for (size_t ti = 0; ti < m_tiles; ++ti) tile_row(ti);
+    } else {
+        parallel::parallel_for(m_tiles, tile_row);
+    }
+}
+
+/**
+ * @brief a matrix stored as TS x TS row-major tiles in the Z order of layout::Morton; the tile at offset i of the
+ * quadtree (see layout::MortonNode) starts at data + i * ld
+ */
+template <typename T>
+struct MortonView {
+    T *data;
+    size_t ld;  ///< elements from the start of one tile to the next; at least TS * TS
+
+    [[nodiscard]] T *tile(const layout::MortonNode &node) const noexcept { return data + node.offset * ld; }
+};
+
+namespace detail
+{
+/**
+ * @brief call f(a, b, c) on the nodes of C = A * B that many levels down the quadtrees, or on single tiles; for each
+ * node of C, the nodes of A and B come in the order of the inner dimension
+ */
+template <typename F>
+void morton_split(const layout::MortonNode &a, const layout::MortonNode &b, const layout::MortonNode &c, size_t levels,
+                  F &&f)
+{
+    if (levels == 0 || (a.leaf() && b.leaf())) {
+        f(a, b, c);
+        return;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            const layout::MortonNode c_child = c.child(i, j);
+            if (c_child.rows == 0 || c_child.cols == 0) continue;
+            for (size_t p = 0; p < 2; ++p) {
+                const layout::MortonNode a_child = a.child(i, p);
+                if (a_child.cols == 0) continue;
+                morton_split(a_child, b.child(p, j), c_child, levels - 1, f);
+            }
+        }
+    }
+}
+}  // namespace detail
+
+/**
+ * @brief C += A * B for matrices in layout::Morton with the same tiles, recursing down the quadtrees to single tiles
+ * with no packing: every node is a contiguous block already. As in \ref tiled_gemm, tiles run whole except along the
+ * inner dimension, which stops at k. Products of at least \ref PARALLEL_GEMM_VOLUME cut C into nodes a few levels
+ * down and run those on the thread pool; the order of the additions into an element of C stays the same
+ * @param a_root, b_root, c_root the whole tile grids, e.g. Map::root() of each matrix
+ * @param k inner dimension, in elements
+ * @param ts tile size
+ */
+template <typename T, typename TA, typename TB>
+void morton_gemm(const layout::MortonNode &a_root, const layout::MortonNode &b_root, const layout::MortonNode &c_root,
+                 size_t k, size_t ts, const MortonView<const TA> &a, const MortonView<const TB> &b,
+                 const MortonView<T> &c)
+{
+    const auto tile = [&](const layout::MortonNode &an, const layout::MortonNode &bn, const layout::MortonNode &cn) {
+        const TA *in_a = a.tile(an);
+        const TB *in_b = b.tile(bn);
+        T *out = c.tile(cn);
+        const size_t depth = std::min(ts, k - an.col0 * ts);
+        for (size_t i = 0; i < ts; ++i) {
+            for (size_t p = 0; p < depth; ++p) {
+                const T x = static_cast<T>(in_a[i * ts + p]);
+                const TB *row_b = in_b + p * ts;
+                T *row_c = out + i * ts;
+                for (size_t j = 0; j < ts; ++j) row_c[j] += x * static_cast<T>(row_b[j]);
+            }
+        }
+    };
+    const auto recurse = [&](const layout::MortonNode &an, const layout::MortonNode &bn,
+                             const layout::MortonNode &cn) { detail::morton_split(an, bn, cn, SIZE_MAX, tile); };
+
+    const size_t threads = parallel::num_threads();
+    if (threads <= 1 || c_root.rows * c_root.cols * a_root.cols * ts * ts * ts < PARALLEL_GEMM_VOLUME) {
+        recurse(a_root, b_root, c_root);
+        return;
+    }
+    // deep enough for TILES_PER_THREAD nodes of C per thread
+    size_t levels = 0;
+    for (size_t nodes = 1; nodes < threads * TILES_PER_THREAD; nodes *= 4) ++levels;
+    struct Job {
+        layout::MortonNode a, b, c;
+    };
+    std::vector<Job> jobs;
+    detail::morton_split(a_root, b_root, c_root, levels, [&](const auto &an, const auto &bn, const auto &cn) {
+        jobs.push_back({an, bn, cn});
+    });
+    // the jobs of one node of C run on one thread, in their order
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job &x, const Job &y) { return x.c.offset < y.c.offset; });
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (i == 0 || jobs[i].c.offset != jobs[i - 1].c.offset) starts.push_back(i);
+    }
+    starts.push_back(jobs.size());
+    parallel::parallel_for(starts.size() - 1, [&](size_t t) {
+        for (size_t i = starts[t]; i < starts[t + 1]; ++i) recurse(jobs[i].a, jobs[i].b, jobs[i].c);
+    });
+}
+
+/**
+ * @brief dst := src^T for matrices in layout::Morton with the same tiles: quadrant (i, j) of src goes to quadrant
+ * (j, i) of dst, down to single tiles, which are transposed whole (padding to padding)
+ * @param src_node, dst_node the whole tile grids; dst_node has the shape of src_node transposed
+ */
+template <typename T, typename E>
+void morton_transpose(const layout::MortonNode &src_node, const layout::MortonNode &dst_node, size_t ts,
+                      const MortonView<const E> &src, const MortonView<T> &dst)
+{
+    if (src_node.leaf()) {
+        const E *in = src.tile(src_node);
+        T *out = dst.tile(dst_node);
+        for (size_t i = 0; i < ts; ++i) {
+            for (size_t j = 0; j < ts; ++j) out[j * ts + i] = in[i * ts + j];
+        }
+        return;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            const layout::MortonNode child = src_node.child(i, j);
+            if (child.rows != 0 && child.cols != 0) morton_transpose(child, dst_node.child(j, i), ts, src, dst);
+        }
+    }
+}
+
+}  // namespace engine
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_GEMM_HPP
@@ -0,0 +1,471 @@
+#ifndef TOY_GEMM_KERNELS_HPP
+#define TOY_GEMM_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "cpu.hpp"
+
+#if TOY_GEMM_X86_DISPATCH || defined(__SSE4_2__) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#define TOY_GEMM_HAS_SSE4_2_KERNELS 1
+#endif
+#if TOY_GEMM_X86_DISPATCH || (defined(__AVX2__) && defined(__FMA__)) || defined(__AVX512F__)
+#define TOY_GEMM_HAS_AVX2_KERNELS 1
+#endif
+#if TOY_GEMM_X86_DISPATCH || defined(__AVX512F__)
+#define TOY_GEMM_HAS_AVX512_KERNELS 1
+#endif
+
+namespace toy_gemm
+{
+namespace engine
+{
+/**
+ * @brief computes C := alpha * A * B + beta * C for one MR x NR tile of C
+ * @param kc depth of the packed panels
+ * @param a packed panel of A, kc slivers of MR elements each
+ * @param b packed panel of B, kc slivers of NR elements each
+ * @param c top left element of the tile
+ * @param rs_c row stride of C
+ * @param cs_c column stride of C
+ * @note when beta == 0, C is write-only, so it may hold garbage (or NaN) on entry
+ */
+template <typename T>
+using KernelFn = void (*)(size_t kc, const T *a, const T *b, T *c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c, T alpha,
+                          T beta);
+
+/**
+ * @brief a microkernel together with the register block it computes
+ */
+template <typename T>
+struct MicroKernel {
+    KernelFn<T> fn;
+    size_t mr;
+    size_t nr;
+};
+
+constexpr size_t MAX_KERNEL_TILE = 256;  ///< upper bound of mr * nr over every microkernel
+
+/**
+ * @brief portable microkernel; keeps an MR x NR block of C in local accumulators for the whole kc loop
+ */
+template <typename T, size_t MR, size_t NR>
+void generic_kernel(size_t kc, const T *a, const T *b, T *c, std::ptrdiff_t rs_c, std::ptrdiff_t cs_c, T alpha,
+                    T beta)
+{
+    T acc[MR][NR]{};
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+    }
+    const bool overwrite = beta == T{};
+    for (size_t i = 0; i < MR; ++i) {
+        for (size_t j = 0; j < NR; ++j) {
+            T &dst = c[static_cast<std::ptrdiff_t>(i) * rs_c + static_cast<std::ptrdiff_t>(j) * cs_c];
+            dst = overwrite ? alpha * acc[i][j] : alpha * acc[i][j] + beta * dst;
+        }
+    }
+}
+
+/**
+ * @brief transposes one block x block block: dst(j, i) := src(i, j), rows of src ld_src elements apart and rows of dst
+ * ld_dst elements apart
+ */
+template <typename T>
+using TransposeFn = void (*)(const T *src, std::ptrdiff_t ld_src, T *dst, std::ptrdiff_t ld_dst);
+
+constexpr size_t MAX_TRANSPOSE_BLOCK = 8;  ///< upper bound of the block of every block transpose
+
+/**
+ * @brief a block transpose together with the size of the square block it moves
+ */
+template <typename T>
+struct TransposeKernel {
+    TransposeFn<T> fn;
+    size_t block;
+};
+
+/**
+ * @brief portable block transpose; a plain loop the compiler can unroll
+ */
+template <typename T, size_t B>
+void generic_transpose(const T *src, std::ptrdiff_t ld_src, T *dst, std::ptrdiff_t ld_dst)
+{
+    for (size_t i = 0; i < B; ++i) {
+        for (size_t j = 0; j < B; ++j) {
+            dst[static_cast<std::ptrdiff_t>(j) * ld_dst + static_cast<std::ptrdiff_t>(i)] =
+                src[static_cast<std::ptrdiff_t>(i) * ld_src + static_cast<std::ptrdiff_t>(j)];
+        }
+    }
+}
+
+/**
+ * @brief element types that have hand-written vector kernels
+ */
+template <typename T>
+constexpr bool HAS_SIMD_KERNEL =
+    std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, std::int32_t>;
+
+// Every instruction set below provides Ops<T> for the three element types: thin wrappers over the intrinsics with a
+// common interface, so that detail/simd_kernel.inl can be written once. Each register block keeps MR * NV
+// accumulators plus NV vectors of B and one broadcast of A in registers.
+// The Ops and the kernel body are compiled for their instruction set inside TOY_GEMM_TARGET_*_BEGIN/END; the kernel()
+// getters stay outside, since they run before anyone has checked that the CPU supports the instruction set.
+// Transposes only move bits, so float and int32 share one kernel over integer vectors; AVX-512 uses those of AVX2.
+
+#if TOY_GEMM_HAS_AVX512_KERNELS
+TOY_GEMM_TARGET_AVX512_BEGIN
+namespace avx512
+{
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<float> {
+    using Elem = float;
+    using Vec = __m512;
+    constexpr static size_t WIDTH = 16;
+    static Vec zero() noexcept { return _mm512_setzero_ps(); }
+    static Vec broadcast(float x) noexcept { return _mm512_set1_ps(x); }
+    static Vec load(const float *p) noexcept { return _mm512_loadu_ps(p); }
+    static void store(float *p, Vec v) noexcept { _mm512_storeu_ps(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm512_mul_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+};
+
+template <>
+struct Ops<double> {
+    using Elem = double;
+    using Vec = __m512d;
+    constexpr static size_t WIDTH = 8;
+    static Vec zero() noexcept { return _mm512_setzero_pd(); }
+    static Vec broadcast(double x) noexcept { return _mm512_set1_pd(x); }
+    static Vec load(const double *p) noexcept { return _mm512_loadu_pd(p); }
+    static void store(double *p, Vec v) noexcept { _mm512_storeu_pd(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm512_mul_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm512_fmadd_pd(a, b, c); }
+};
+
+template <>
+struct Ops<std::int32_t> {
+    using Elem = std::int32_t;
+    using Vec = __m512i;
+    constexpr static size_t WIDTH = 16;
+    static Vec zero() noexcept { return _mm512_setzero_si512(); }
+    static Vec broadcast(std::int32_t x) noexcept { return _mm512_set1_epi32(x); }
+    static Vec load(const std::int32_t *p) noexcept { return _mm512_loadu_si512(p); }
+    static void store(std::int32_t *p, Vec v) noexcept { _mm512_storeu_si512(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm512_mullo_epi32(a, b); }
+    // no fused multiply-add for 32 bit integers
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+};
+
+#include "detail/simd_kernel.inl"
+}  // namespace avx512
+TOY_GEMM_TARGET_END
+
+namespace avx512
+{
+/**
+ * @brief 6 x 2 vectors: 12 of the 32 zmm registers hold accumulators
+ */
+template <typename T>
+[[nodiscard]] MicroKernel<T> kernel() noexcept
+{
+    return {&simd_kernel<Ops<T>, 6, 2>, 6, 2 * Ops<T>::WIDTH};
+}
+}  // namespace avx512
+#endif
+
+#if TOY_GEMM_HAS_AVX2_KERNELS
+TOY_GEMM_TARGET_AVX2_BEGIN
+namespace avx2
+{
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<float> {
+    using Elem = float;
+    using Vec = __m256;
+    constexpr static size_t WIDTH = 8;
+    static Vec zero() noexcept { return _mm256_setzero_ps(); }
+    static Vec broadcast(float x) noexcept { return _mm256_set1_ps(x); }
+    static Vec load(const float *p) noexcept { return _mm256_loadu_ps(p); }
+    static void store(float *p, Vec v) noexcept { _mm256_storeu_ps(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm256_mul_ps(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+};
+
+template <>
+struct Ops<double> {
+    using Elem = double;
+    using Vec = __m256d;
+    constexpr static size_t WIDTH = 4;
+    static Vec zero() noexcept { return _mm256_setzero_pd(); }
+    static Vec broadcast(double x) noexcept { return _mm256_set1_pd(x); }
+    static Vec load(const double *p) noexcept { return _mm256_loadu_pd(p); }
+    static void store(double *p, Vec v) noexcept { _mm256_storeu_pd(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm256_mul_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+};
+
+template <>
+struct Ops<std::int32_t> {
+    using Elem = std::int32_t;
+    using Vec = __m256i;
+    constexpr static size_t WIDTH = 8;
+    static Vec zero() noexcept { return _mm256_setzero_si256(); }
+    static Vec broadcast(std::int32_t x) noexcept { return _mm256_set1_epi32(x); }
+    static Vec load(const std::int32_t *p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const Vec *>(p)); }
+    static void store(std::int32_t *p, Vec v) noexcept { _mm256_storeu_si256(reinterpret_cast<Vec *>(p), v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm256_mullo_epi32(a, b); }
+    // no fused multiply-add for 32 bit integers
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+};
+
+#include "detail/simd_kernel.inl"
+
+/**
+ * @brief 8 x 8 transpose of 32-bit elements in eight ymm registers: pairs of rows interleave into 2 x 2 blocks, then
+ * into 4 x 4 blocks within each 128-bit lane, and the lanes swap last
+ */
+template <typename T>
+void transpose_8x8(const T *src, std::ptrdiff_t ld_src, T *dst, std::ptrdiff_t ld_dst)
+{
+    static_assert(sizeof(T) == 4, "32-bit elements only");
+    __m256i r[8];
+    for (std::ptrdiff_t i = 0; i < 8; ++i) {
+        r[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * ld_src));
+    }
+    __m256i t[8];
+    for (size_t i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    __m256i u[8];
+    for (size_t i = 0; i < 8; i += 4) {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    // u[j] holds column j in its low lane and column j + 4 in its high lane, for rows 0 to 3; u[j + 4] for rows 4 to 7
+    for (std::ptrdiff_t j = 0; j < 4; ++j) {
+        const __m256i low = _mm256_permute2x128_si256(u[j], u[j + 4], 0x20);
+        const __m256i high = _mm256_permute2x128_si256(u[j], u[j + 4], 0x31);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + j * ld_dst), low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + (j + 4) * ld_dst), high);
+    }
+}
+
+/**
+ * @brief 4 x 4 transpose of doubles: pairs of rows interleave into 2 x 2 blocks, then the 128-bit lanes swap
+ */
+inline void transpose_4x4(const double *src, std::ptrdiff_t ld_src, double *dst, std::ptrdiff_t ld_dst)
+{
+    const __m256d r0 = _mm256_loadu_pd(src);
+    const __m256d r1 = _mm256_loadu_pd(src + ld_src);
+    const __m256d r2 = _mm256_loadu_pd(src + 2 * ld_src);
+    const __m256d r3 = _mm256_loadu_pd(src + 3 * ld_src);
+    const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + ld_dst, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2 * ld_dst, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3 * ld_dst, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+}  // namespace avx2
+TOY_GEMM_TARGET_END
+
+namespace avx2
+{
+/**
+ * @brief 6 x 2 vectors: 12 of the 16 ymm registers hold accumulators
+ */
+template <typename T>
+[[nodiscard]] MicroKernel<T> kernel() noexcept
+{
+    return {&simd_kernel<Ops<T>, 6, 2>, 6, 2 * Ops<T>::WIDTH};
+}
+
+template <typename T>
+[[nodiscard]] TransposeKernel<T> transpose_kernel() noexcept
+{
+    if constexpr (std::is_same_v<T, double>) {
+        return {&transpose_4x4, 4};
+    } else {
+        return {&transpose_8x8<T>, 8};
+    }
+}
+}  // namespace avx2
+#endif
+
+#if TOY_GEMM_HAS_SSE4_2_KERNELS
+TOY_GEMM_TARGET_SSE4_2_BEGIN
+namespace sse4_2
+{
+template <typename T>
+struct Ops;
+
+template <>
+struct Ops<float> {
+    using Elem = float;
+    using Vec = __m128;
+    constexpr static size_t WIDTH = 4;
+    static Vec zero() noexcept { return _mm_setzero_ps(); }
+    static Vec broadcast(float x) noexcept { return _mm_set1_ps(x); }
+    static Vec load(const float *p) noexcept { return _mm_loadu_ps(p); }
+    static void store(float *p, Vec v) noexcept { _mm_storeu_ps(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm_mul_ps(a, b); }
+    // no FMA before AVX2-era cores
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+};
+
+template <>
+struct Ops<double> {
+    using Elem = double;
+    using Vec = __m128d;
+    constexpr static size_t WIDTH = 2;
+    static Vec zero() noexcept { return _mm_setzero_pd(); }
+    static Vec broadcast(double x) noexcept { return _mm_set1_pd(x); }
+    static Vec load(const double *p) noexcept { return _mm_loadu_pd(p); }
+    static void store(double *p, Vec v) noexcept { _mm_storeu_pd(p, v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm_mul_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+};
+
+template <>
+struct Ops<std::int32_t> {
+    using Elem = std::int32_t;
+    using Vec = __m128i;
+    constexpr static size_t WIDTH = 4;
+    static Vec zero() noexcept { return _mm_setzero_si128(); }
+    static Vec broadcast(std::int32_t x) noexcept { return _mm_set1_epi32(x); }
+    static Vec load(const std::int32_t *p) noexcept { return _mm_loadu_si128(reinterpret_cast<const Vec *>(p)); }
+    static void store(std::int32_t *p, Vec v) noexcept { _mm_storeu_si128(reinterpret_cast<Vec *>(p), v); }
+    static Vec mul(Vec a, Vec b) noexcept { return _mm_mullo_epi32(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c) noexcept { return _mm_add_epi32(_mm_mullo_epi32(a, b), c); }
+};
+
+#include "detail/simd_kernel.inl"
+
+/**
+ * @brief 4 x 4 transpose of 32-bit elements in four xmm registers: pairs of rows interleave into 2 x 2 blocks, which
+ * then combine by halves
+ */
+template <typename T>
+void transpose_4x4(const T *src, std::ptrdiff_t ld_src, T *dst, std::ptrdiff_t ld_dst)
+{
+    static_assert(sizeof(T) == 4, "32-bit elements only");
+    __m128i r[4];
+    for (std::ptrdiff_t i = 0; i < 4; ++i) r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * ld_src));
+    const __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+    const __m128i t1 = _mm_unpackhi_epi32(r[0], r[1]);
+    const __m128i t2 = _mm_unpacklo_epi32(r[2], r[3]);
+    const __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi64(t0, t2));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + ld_dst), _mm_unpackhi_epi64(t0, t2));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * ld_dst), _mm_unpacklo_epi64(t1, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 3 * ld_dst), _mm_unpackhi_epi64(t1, t3));
+}
+
+/**
+ * @brief 2 x 2 transpose of doubles
+ */
+inline void transpose_2x2(const double *src, std::ptrdiff_t ld_src, double *dst, std::ptrdiff_t ld_dst)
+{
+    const __m128d r0 = _mm_loadu_pd(src);
+    const __m128d r1 = _mm_loadu_pd(src + ld_src);
+    _mm_storeu_pd(dst, _mm_unpacklo_pd(r0, r1));
+    _mm_storeu_pd(dst + ld_dst, _mm_unpackhi_pd(r0, r1));
+}
+}  // namespace sse4_2
+TOY_GEMM_TARGET_END
+
+namespace sse4_2
+{
+/**
+ * @brief 4 x 2 vectors: 8 of the 16 xmm registers hold accumulators
+ */
+template <typename T>
+[[nodiscard]] MicroKernel<T> kernel() noexcept
+{
+    return {&simd_kernel<Ops<T>, 4, 2>, 4, 2 * Ops<T>::WIDTH};
+}
+
+template <typename T>
+[[nodiscard]] TransposeKernel<T> transpose_kernel() noexcept
+{
+    if constexpr (std::is_same_v<T, double>) {
+        return {&transpose_2x2, 2};
+    } else {
+        return {&transpose_4x4<T>, 4};
+    }
+}
+}  // namespace sse4_2
+#endif
+
+/**
+ * @brief pick the microkernel used for element type T
+ * the widest instruction set that \ref cpu::active_isa allows wins; types without a vector kernel get the portable one
+ */
+template <typename T>
+[[nodiscard]] MicroKernel<T> select_kernel() noexcept
+{
+    if constexpr (HAS_SIMD_KERNEL<T>) {
+        switch (cpu::active_isa()) {
+#if TOY_GEMM_HAS_AVX512_KERNELS
+            case cpu::Isa::AVX512:
+                return avx512::kernel<T>();
+#endif
+#if TOY_GEMM_HAS_AVX2_KERNELS
+            case cpu::Isa::AVX2:
+                return avx2::kernel<T>();
+#endif
+#if TOY_GEMM_HAS_SSE4_2_KERNELS
+            case cpu::Isa::SSE4_2:
+                return sse4_2::kernel<T>();
+#endif
+            default:
+                break;
+        }
+    }
+    return {&generic_kernel<T, 4, 4>, 4, 4};
+}
+
+/**
+ * @brief pick the block transpose used for element type T, like \ref select_kernel
+ */
+template <typename T>
+[[nodiscard]] TransposeKernel<T> select_transpose_kernel() noexcept
+{
+    if constexpr (HAS_SIMD_KERNEL<T>) {
+        switch (cpu::active_isa()) {
+#if TOY_GEMM_HAS_AVX2_KERNELS
+            case cpu::Isa::AVX512:
+            case cpu::Isa::AVX2:
+                return avx2::transpose_kernel<T>();
+#endif
+#if TOY_GEMM_HAS_SSE4_2_KERNELS
+            case cpu::Isa::SSE4_2:
+                return sse4_2::transpose_kernel<T>();
+#endif
+            default:
+                break;
+        }
+    }
+    return {&generic_transpose<T, 4>, 4};
+}
+
+}  // namespace engine
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_KERNELS_HPP
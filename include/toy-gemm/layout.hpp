@@ -0,0 +1,174 @@
+#ifndef TOY_GEMM_LAYOUT_HPP
+#define TOY_GEMM_LAYOUT_HPP
+
+#include <cstddef>
+
+/**
+ * Layouts for \ref Mat, its optional 5th template parameter. A layout decides which element goes where: it cuts an
+ * R x C matrix into lines, which the storage policy (storage.hpp) then lays out in memory. It provides a member template
+ * @code
+ * template <size_t R, size_t C> struct Map;
+ * @endcode
+ * with
+ * - @c LINES and @c LEN, the number of lines and the elements per line
+ * - @c line(r, c) and @c offset(r, c), where element (r, c) lives
+ * - @c STRIDED, whether element (r, c) is at line r * row_stride(LD) + c * col_stride(LD) from the first element, for a
+ * storage policy putting the starts of consecutive lines LD elements apart; only strided layouts can be handed to
+ * the gemm engine as they are
+ */
+
+namespace toy_gemm
+{
+namespace layout
+{
+/**
+ * @brief a line per row; the default
+ */
+struct RowMajor final {
+    template <size_t R, size_t C>
+    struct Map {
+        constexpr static size_t LINES = R;
+        constexpr static size_t LEN = C;
+        constexpr static bool STRIDED = true;
+
+        [[nodiscard]] static constexpr size_t line(size_t r, size_t) noexcept { return r; }
+        [[nodiscard]] static constexpr size_t offset(size_t, size_t c) noexcept { return c; }
+
+        [[nodiscard]] static constexpr size_t row_stride(size_t ld) noexcept { return ld; }
+        [[nodiscard]] static constexpr size_t col_stride(size_t) noexcept { return 1; }
+    };
+};
+
+/**
+ * @brief a line per column, so columns are contiguous and rows are strided
+ */
+struct ColMajor final {
+    template <size_t R, size_t C>
+    struct Map {
+        constexpr static size_t LINES = C;
+        constexpr static size_t LEN = R;
+        constexpr static bool STRIDED = true;
+
+        [[nodiscard]] static constexpr size_t line(size_t, size_t c) noexcept { return c; }
+        [[nodiscard]] static constexpr size_t offset(size_t r, size_t) noexcept { return r; }
+
+        [[nodiscard]] static constexpr size_t row_stride(size_t) noexcept { return 1; }
+        [[nodiscard]] static constexpr size_t col_stride(size_t ld) noexcept { return ld; }
+    };
+};
+
+/**
+ * @brief a line per TR x TC tile, tiles in row-major order and the elements of a tile too
+ * a tile is a contiguous block that fits in a few cache lines, so products of tiled matrices can run tile by tile
+ * without packing. The tiles on the bottom and right edges are padded when TR does not divide R or TC does not
+ * divide C; that padding only ever feeds padding, like the one of storage::Aligned
+ */
+template <size_t TR, size_t TC = TR>
+struct Tiled final {
+    static_assert(TR > 0 && TC > 0, "tiles can't be empty");
+
+    constexpr static size_t TILE_ROWS = TR;
+    constexpr static size_t TILE_COLS = TC;
+
+    template <size_t R, size_t C>
+    struct Map {
+        constexpr static size_t ROW_TILES = (R + TR - 1) / TR;
+        constexpr static size_t COL_TILES = (C + TC - 1) / TC;
+        constexpr static size_t LINES = ROW_TILES * COL_TILES;
+        constexpr static size_t LEN = TR * TC;
+        constexpr static bool STRIDED = false;
+
+        [[nodiscard]] static constexpr size_t line(size_t r, size_t c) noexcept { return r / TR * COL_TILES + c / TC; }
+        [[nodiscard]] static constexpr size_t offset(size_t r, size_t c) noexcept { return r % TR * TC + c % TC; }
+    };
+};
+
+/**
+ * @brief a block of the tile grid of a layout::Morton matrix: the tiles of a node are contiguous, and so are those of
+ * each of its four children (quadrants), which come in Z order: top-left, top-right, bottom-left, bottom-right
+ * a node of rows x cols tiles splits into (rows + 1) / 2 and rows / 2 tiles down, and likewise across; once a side
+ * is down to one tile, only the other one splits, so grids of any shape are stored without holes. On a square grid of
+ * 2^n x 2^n tiles this is the classic Morton order
+ */
+struct MortonNode final {
+    size_t offset;  ///< tiles stored before the first tile of this node
+    size_t rows;    ///< tiles down
+    size_t cols;    ///< tiles across
+    size_t row0;    ///< tile row of the top-left tile
+    size_t col0;    ///< tile column of the top-left tile
+
+    [[nodiscard]] constexpr bool leaf() const noexcept { return rows == 1 && cols == 1; }
+    [[nodiscard]] constexpr size_t top() const noexcept { return (rows + 1) / 2; }    ///< tiles down the top children
+    [[nodiscard]] constexpr size_t left() const noexcept { return (cols + 1) / 2; }  ///< tiles across the left children
+
+    /**
+     * @return the bottom (i = 1) or top (i = 0), right (j = 1) or left (j = 0) child; empty (no rows or no columns)
+     * where a side of one tile does not split
+     */
+    [[nodiscard]] constexpr MortonNode child(size_t i, size_t j) const noexcept
+    {
+        const size_t child_rows = i == 0 ? top() : rows - top();
+        const size_t child_cols = j == 0 ? left() : cols - left();
+        const size_t before = (i == 0 ? 0 : top() * cols) + (j == 0 ? 0 : child_rows * left());
+        return {offset + before, child_rows, child_cols, row0 + (i == 0 ? 0 : top()), col0 + (j == 0 ? 0 : left())};
+    }
+};
+
+/**
+ * @brief a line per TS x TS tile like Tiled<TS>, but with the tiles in Z (Morton) order, see \ref MortonNode
+ * the quadrants of a matrix, their quadrants and so on down to single tiles are each contiguous, so a recursive
+ * algorithm touches one contiguous range of memory per sub-block at every depth, which keeps it within few pages
+ * and cache sets. Products of two Morton matrices with the same tiles, and transposes, run on the quadtree natively;
+ * converting to and from the other layouts is the converting constructor of Mat. Finding the tile of an element
+ * descends the quadtree, so single element accesses take O(log(tiles)) steps
+ */
+template <size_t TS = 8>
+struct Morton final {
+    static_assert(TS > 0, "tiles can't be empty");
+
+    constexpr static size_t TILE_ROWS = TS;
+    constexpr static size_t TILE_COLS = TS;
+
+    template <size_t R, size_t C>
+    struct Map {
+        constexpr static size_t ROW_TILES = (R + TS - 1) / TS;
+        constexpr static size_t COL_TILES = (C + TS - 1) / TS;
+        constexpr static size_t LINES = ROW_TILES * COL_TILES;
+        constexpr static size_t LEN = TS * TS;
+        constexpr static bool STRIDED = false;
+
+        [[nodiscard]] static constexpr MortonNode root() noexcept { return {0, ROW_TILES, COL_TILES, 0, 0}; }
+
+        [[nodiscard]] static constexpr size_t line(size_t r, size_t c) noexcept
+        {
+            MortonNode node = root();
+            while (!node.leaf()) node = node.child(r / TS >= node.row0 + node.top(), c / TS >= node.col0 + node.left());
+            return node.offset;
+        }
+
+        [[nodiscard]] static constexpr size_t offset(size_t r, size_t c) noexcept { return r % TS * TS + c % TS; }
+    };
+};
+
+namespace detail
+{
+template <typename L>
+constexpr bool IS_MORTON = false;
+
+template <size_t TS>
+constexpr bool IS_MORTON<Morton<TS>> = true;
+
+/**
+ * @brief whether a matrix in layout A times one in layout B can run tile by tile into a result in layout A: the
+ * tiles of B must be as tall as those of A are wide, and as wide as those of the result
+ */
+template <typename A, typename B>
+constexpr bool TILES_FIT = false;
+
+template <size_t P, size_t Q>
+constexpr bool TILES_FIT<Tiled<P, Q>, Tiled<Q, Q>> = true;
+}  // namespace detail
+}  // namespace layout
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_LAYOUT_HPP
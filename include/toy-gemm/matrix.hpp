@@ -2,49 +2,398 @@
 #define TOY_GEMM_MATRIX_HPP
 
 #include <array>
+#include <cstdio>
+#include <cstdlib>
 #include <exception>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include "gemm.hpp"
+#include "layout.hpp"
+#include "storage.hpp"
+
+/**
+ * Operations that are constexpr but run other code at runtime (the gemm engine, vector kernels) tell the two apart
+ * with __builtin_is_constant_evaluated, the builtin behind C++20 std::is_constant_evaluated: GCC 9, clang 9 and MSVC
+ * 19.25 on. Without it they could not be constant expressions, so older compilers are turned away here
+ */
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define TOY_GEMM_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+#endif
+#if !defined(TOY_GEMM_HAS_IS_CONSTANT_EVALUATED) && \
+    ((defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define TOY_GEMM_HAS_IS_CONSTANT_EVALUATED 1
+#endif
+#ifndef TOY_GEMM_HAS_IS_CONSTANT_EVALUATED
+#error "toy-gemm needs __builtin_is_constant_evaluated: GCC 9, clang 9, MSVC 19.25 or newer"
+#endif
+
+/**
+ * Bounds checks of the unchecked accessors (operator[] of matrices, rows and columns): on unless NDEBUG is defined,
+ * like assert, and then an out-of-range index aborts. Define TOY_GEMM_BOUNDS_CHECK to 0 or 1 to choose regardless of
+ * NDEBUG. at() always checks, and throws std::out_of_range
+ */
+#ifndef TOY_GEMM_BOUNDS_CHECK
+#ifdef NDEBUG
+#define TOY_GEMM_BOUNDS_CHECK 0
+#else
+#define TOY_GEMM_BOUNDS_CHECK 1
+#endif
+#endif
+
 namespace toy_gemm
 {
 template <typename T, size_t C>
 using Vec = std::array<T, C>;  ///< choosing std::array to represent a 1D vector
 
-template <size_t R, size_t C = R, typename T = int>
+template <typename T>
+class MatMap;  ///< runtime-sized view, see dyn_matrix.hpp
+
+namespace detail
+{
+/**
+ * @brief true for the lazy expressions of expr.hpp, which can be assigned to (and accumulated into) a matrix
+ */
+template <typename X, typename = void>
+constexpr bool IS_GEMM_EXPR = false;
+
+template <typename X>
+constexpr bool IS_GEMM_EXPR<X, std::void_t<typename X::GemmExprTag>> = true;
+
+/**
+ * @brief whether matrices of A and of B hold the same values: a view of const elements reads like any other matrix
+ */
+template <typename A, typename B>
+constexpr bool SAME_ELEM = std::is_same_v<std::remove_const_t<A>, std::remove_const_t<B>>;
+
+/**
+ * @brief C++17 stand-in for C++20 std::is_constant_evaluated
+ * @return true while being evaluated at compile time, false at runtime
+ */
+constexpr bool is_constant_evaluated() noexcept { return __builtin_is_constant_evaluated(); }
+
+[[noreturn]] inline void index_out_of_range(const char *what) noexcept
+{
+    std::fprintf(stderr, "toy_gemm: %s index out of range\n", what);
+    std::abort();
+}
+
+/**
+ * @brief the check of an unchecked accessor: nothing, unless TOY_GEMM_BOUNDS_CHECK; then abort if the index is not in
+ * range. Failing it at compile time is a compile error
+ */
+constexpr void check_index([[maybe_unused]] size_t i, [[maybe_unused]] size_t n,
+                           [[maybe_unused]] const char *what) noexcept
+{
+#if TOY_GEMM_BOUNDS_CHECK
+    if (i >= n) index_out_of_range(what);
+#endif
+}
+
+/**
+ * @throw std::out_of_range unless the br x bc block with top-left element (r0, c0) fits in a rows x cols matrix
+ */
+inline void check_block(size_t rows, size_t cols, size_t r0, size_t c0, size_t br, size_t bc)
+{
+    if (r0 > rows || br > rows - r0) throw std::out_of_range("block rows out of range");
+    if (c0 > cols || bc > cols - c0) throw std::out_of_range("block columns out of range");
+}
+}  // namespace detail
+
+/**
+ * @brief zero-copy view of the transpose of a matrix
+ * element (r, c) of the view is element (c, r) of the viewed matrix; the products in this library read it through
+ * swapped strides, so e.g. @c A * B.transpose_view() never materializes the transpose of B
+ * @tparam M the viewed matrix type; any of \ref Mat or DynMat
+ * @note the view refers to the matrix it was made from, which has to outlive it
+ */
+template <typename M>
+class TransposeView
+{
+   public:
+    using MatType = M;
+    using ElemType = typename M::ElemType;
+
+    constexpr explicit TransposeView(const M &m) noexcept : m_(&m) {}
+
+    [[nodiscard]] constexpr const M &base() const noexcept { return *m_; }
+
+    [[nodiscard]] constexpr size_t row_count() const noexcept { return m_->col_count(); }
+    [[nodiscard]] constexpr size_t col_count() const noexcept { return m_->row_count(); }
+
+    [[nodiscard]] constexpr const ElemType &at(size_t r, size_t c) const { return m_->at(c, r); }
+
+    /**
+     * @return the viewed matrix as a strided operand of the gemm engine, with rows and columns swapped
+     */
+    [[nodiscard]] engine::StridedView<const ElemType> view() const noexcept
+    {
+        const auto v = m_->view();
+        return {v.data, v.col_stride, v.row_stride};
+    }
+
+   private:
+    const M *m_;
+};
+
+/**
+ * @brief random-access iterator over elements stride apart, e.g. down a column of a row-major matrix
+ */
+template <typename T>
+class StridedIterator
+{
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T *;
+    using reference = T &;
+
+    constexpr StridedIterator() noexcept = default;
+
+    constexpr StridedIterator(T *p, std::ptrdiff_t stride) noexcept : p_(p), stride_(stride) {}
+
+    constexpr operator StridedIterator<const T>() const noexcept  // NOLINT: implicit on purpose
+    {
+        return {p_, stride_};
+    }
+
+    [[nodiscard]] constexpr T &operator*() const noexcept { return *p_; }
+    [[nodiscard]] constexpr T *operator->() const noexcept { return p_; }
+    [[nodiscard]] constexpr T &operator[](std::ptrdiff_t n) const noexcept { return p_[n * stride_]; }
+
+    constexpr StridedIterator &operator++() noexcept
+    {
+        p_ += stride_;
+        return *this;
+    }
+
+    constexpr StridedIterator operator++(int) noexcept
+    {
+        StridedIterator ret = *this;
+        p_ += stride_;
+        return ret;
+    }
+
+    constexpr StridedIterator &operator--() noexcept
+    {
+        p_ -= stride_;
+        return *this;
+    }
+
+    constexpr StridedIterator operator--(int) noexcept
+    {
+        StridedIterator ret = *this;
+        p_ -= stride_;
+        return ret;
+    }
+
+    constexpr StridedIterator &operator+=(std::ptrdiff_t n) noexcept
+    {
+        p_ += n * stride_;
+        return *this;
+    }
+
+    constexpr StridedIterator &operator-=(std::ptrdiff_t n) noexcept
+    {
+        p_ -= n * stride_;
+        return *this;
+    }
+
+    [[nodiscard]] constexpr StridedIterator operator+(std::ptrdiff_t n) const noexcept
+    {
+        return {p_ + n * stride_, stride_};
+    }
+
+    [[nodiscard]] constexpr StridedIterator operator-(std::ptrdiff_t n) const noexcept
+    {
+        return {p_ - n * stride_, stride_};
+    }
+
+    [[nodiscard]] friend constexpr StridedIterator operator+(std::ptrdiff_t n, const StridedIterator &it) noexcept
+    {
+        return it + n;
+    }
+
+    [[nodiscard]] constexpr std::ptrdiff_t operator-(const StridedIterator &other) const noexcept
+    {
+        return (p_ - other.p_) / stride_;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const StridedIterator &other) const noexcept { return p_ == other.p_; }
+    [[nodiscard]] constexpr bool operator!=(const StridedIterator &other) const noexcept { return p_ != other.p_; }
+    [[nodiscard]] constexpr bool operator<(const StridedIterator &other) const noexcept { return p_ < other.p_; }
+    [[nodiscard]] constexpr bool operator>(const StridedIterator &other) const noexcept { return p_ > other.p_; }
+    [[nodiscard]] constexpr bool operator<=(const StridedIterator &other) const noexcept { return p_ <= other.p_; }
+    [[nodiscard]] constexpr bool operator>=(const StridedIterator &other) const noexcept { return p_ >= other.p_; }
+
+   private:
+    T *p_ = nullptr;
+    std::ptrdiff_t stride_ = 1;
+};
+
+/**
+ * @brief non-owning view of a column: size() elements stride() apart
+ * plays the role of RowView for columns: range for, size(), operator[] and at(), and random-access iterators for the
+ * standard algorithms, e.g. @c std::inner_product(a.col(0).begin(), a.col(0).end(), b.col(1).begin(), 0)
+ * @note the view refers to the matrix it was made from, which has to outlive it
+ */
+template <typename T>
+class ColView
+{
+   public:
+    using value_type = std::remove_const_t<T>;
+    using iterator = StridedIterator<T>;
+
+    constexpr ColView(T *data, size_t size, std::ptrdiff_t stride) noexcept : data_(data), size_(size), stride_(stride)
+    {
+    }
+
+    constexpr operator ColView<const T>() const noexcept  // NOLINT: implicit on purpose
+    {
+        return {data_, size_, stride_};
+    }
+
+    [[nodiscard]] constexpr size_t size() const noexcept { return size_; }
+    [[nodiscard]] constexpr std::ptrdiff_t stride() const noexcept { return stride_; }
+    [[nodiscard]] constexpr T *data() const noexcept { return data_; }
+    [[nodiscard]] constexpr iterator begin() const noexcept { return {data_, stride_}; }
+    [[nodiscard]] constexpr iterator end() const noexcept { return begin() + static_cast<std::ptrdiff_t>(size_); }
+
+    [[nodiscard]] constexpr T &operator[](size_t r) const noexcept
+    {
+        detail::check_index(r, size_, "row");
+        return begin()[static_cast<std::ptrdiff_t>(r)];
+    }
+
+    [[nodiscard]] constexpr T &at(size_t r) const
+    {
+        if (r >= size_) throw std::out_of_range("row index out of range");
+        return (*this)[r];
+    }
+
+   private:
+    T *data_;
+    size_t size_;
+    std::ptrdiff_t stride_;
+};
+
+/**
+ * @brief R x C matrix of T with all its dimensions known at compile time
+ * @tparam S storage policy from storage.hpp, e.g. storage::Aligned<64> to start every row on a cache line and pad it
+ * to a whole number of vectors
+ * @tparam L layout from layout.hpp: layout::RowMajor, layout::ColMajor or layout::Tiled<TR, TC>; row accessors
+ * (operator[], at(r), get<row>(), rows()) need row-major, everything else takes any layout. Every operation accepts
+ * operands with any storage policy and layout, and returns a matrix with those of the left operand (see ResultType)
+ */
+template <size_t R, size_t C = R, typename T = int, typename S = storage::Packed, typename L = layout::RowMajor>
 class Mat
 {
    public:
     using RowType = Vec<T, C>;
     using ColType = Vec<T, R>;
-    using ThisType = Mat<R, C, T>;
+    using ThisType = Mat<R, C, T, S, L>;
+    using ElemType = T;
+    using StoragePolicy = S;
+    using Layout = L;
+    using LayoutMap = typename L::template Map<R, C>;  // C++ template disambiguator
 
     using TRef = typename RowType::reference;
     using TCRef = typename RowType::const_reference;
-    using StorageType = std::array<RowType, R>;
+    using StorageType = typename S::template Buffer<LayoutMap::LINES, LayoutMap::LEN, T>;
+    /// what operations on this matrix return: the same, owning its elements (a MatRef computes Heap Mats)
+    using ResultType = Mat<R, C, std::remove_const_t<T>, typename S::Result, L>;
 
     constexpr static size_t ELEM_COUNT = R * C;
     constexpr static size_t ROW_COUNT = R;
     constexpr static size_t COL_COUNT = C;
+    constexpr static size_t LD = StorageType::LD;  ///< leading dimension: elements between lines; 0 in a view
+    constexpr static bool ROW_MAJOR = std::is_same_v<L, layout::RowMajor>;
+    constexpr static bool COL_MAJOR = std::is_same_v<L, layout::ColMajor>;
+
+    [[nodiscard]] constexpr static size_t row_count() noexcept { return R; }
+    [[nodiscard]] constexpr static size_t col_count() noexcept { return C; }
+
+    /**
+     * @return leading dimension at runtime: LD, or the one a view was made with
+     */
+    [[nodiscard]] constexpr size_t ld() const noexcept { return elems.ld(); }
 
-    ~Mat<R, C, T>() = default;
+    /**
+     * products whose dimensions (R, C and OtherC) are all at most this are computed by a plain loop, which the compiler
+     * unrolls and vectorizes with the sizes known; anything larger goes through the cache-blocked engine in gemm.hpp
+     * at runtime. At compile time every product takes the loop
+     */
+    constexpr static size_t LOOP_MUL_MAX_DIM = 16;
+
+    ~Mat() = default;
 
     // construction
 
     /**
      * @brief default constructor will zero-initialize
      */
-    constexpr Mat<R, C, T>() = default;
+    constexpr Mat() = default;
 
-    constexpr Mat<R, C, T>(const ThisType &) = default;
+    constexpr Mat(const ThisType &) = default;
 
-    constexpr Mat<R, C, T>(ThisType &&) noexcept = default;
+    constexpr Mat(ThisType &&) noexcept = default;
 
-    constexpr Mat<R, C, T> &operator=(const ThisType &) = default;
+    constexpr Mat &operator=(const ThisType &) = default;
 
-    constexpr Mat<R, C, T> &operator=(ThisType &&) noexcept = default;
+    constexpr Mat &operator=(ThisType &&) noexcept = default;
+
+    /**
+     * @brief copy the elements of a matrix with another storage policy or layout, e.g. of a view
+     */
+    template <typename OT, typename OS, typename OL,
+              std::enable_if_t<detail::SAME_ELEM<OT, T> && !std::is_same_v<Mat<R, C, OT, OS, OL>, ThisType>, int> = 0>
+    explicit constexpr Mat(const Mat<R, C, OT, OS, OL> &other)
+    {
+        copy_from(other);
+    }
+
+    /**
+     * @brief view R x C elements owned by someone else, lines ld elements apart; for the storage::Ref policy, see
+     * MatRef
+     * @param data element (0, 0)
+     * @throw std::length_error if ld is shorter than a line
+     */
+    template <typename P, std::enable_if_t<detail::SAME_ELEM<P, T> && std::is_convertible_v<P *, T *> &&
+                                               std::is_constructible_v<StorageType, T *, size_t>,
+                                           int> = 0>
+    constexpr Mat(P *data, size_t ld) : elems(data, ld)
+    {
+    }
+
+    /**
+     * @brief view R x C elements owned by someone else, lines back to back
+     */
+    template <typename P, std::enable_if_t<detail::SAME_ELEM<P, T> && std::is_convertible_v<P *, T *> &&
+                                               std::is_constructible_v<StorageType, T *, size_t>,
+                                           int> = 0>
+    explicit constexpr Mat(P *data) : elems(data, LayoutMap::LEN)
+    {
+    }
+
+    /**
+     * @brief copy the elements of a matrix with another storage policy or layout; through a view, that writes the
+     * viewed elements
+     */
+    template <typename OT, typename OS, typename OL,
+              std::enable_if_t<detail::SAME_ELEM<OT, T> && !std::is_same_v<Mat<R, C, OT, OS, OL>, ThisType>, int> = 0>
+    constexpr ThisType &operator=(const Mat<R, C, OT, OS, OL> &other)
+    {
+        copy_from(other);
+        return *this;
+    }
 
     /**
      * @brief performs either element-wise init or uniform init
@@ -56,8 +405,10 @@ class Mat
      * @c std::is_constructible_v(Mat<R,C,T>,Args...)
      * evaluate to false if sizeof...(Args) is incorrect
      */
-    template <typename... E, std::enable_if_t<ELEM_COUNT == sizeof...(E) || sizeof...(E) == 1, int> = 0>
-    explicit constexpr Mat<R, C, T>(E &&... e) noexcept : elems{std::forward<E>(e)...}
+    template <typename... E, std::enable_if_t<(ELEM_COUNT == sizeof...(E) || sizeof...(E) == 1) &&
+                                                  (std::is_constructible_v<T, E> && ...),
+                                              int> = 0>
+    explicit constexpr Mat(E &&... e) : elems{make_storage(std::forward<E>(e)...)}
     {
         static_assert(ELEM_COUNT == sizeof...(e) || sizeof...(e) == 1,
                       "pass in either exactly one argument, or exactly ELEM_COUNT arguments");
@@ -75,7 +426,7 @@ class Mat
      * constexpr
      */
     template <typename... E>
-    explicit Mat<R, C, T>(std::initializer_list<E> &&... l)
+    explicit Mat(std::initializer_list<E> &&... l)
     {
         static_assert(ROW_COUNT == sizeof...(l));
         const bool every_list_must_have_C_elements = ((COL_COUNT == l.size()) && ...);  // C++17 fold expression
@@ -83,74 +434,162 @@ class Mat
         row_wise_init(std::move(l)...);
     }
 
-    // access (might throw)
-    [[nodiscard]] constexpr const RowType &operator[](size_t r) const
+    /**
+     * @brief evaluate a lazy expression from expr.hpp, e.g. @c Mat m = alpha * A * B + beta * C;
+     * @throw std::length_error if the shape of the expression is not R x C
+     */
+    template <typename Expr, std::enable_if_t<detail::IS_GEMM_EXPR<Expr>, int> = 0>
+    Mat(const Expr &e)  // NOLINT: implicit on purpose
+    {
+        e.assign_to(*this);
+    }
+
+    // unchecked access for inner loops; only checked when TOY_GEMM_BOUNDS_CHECK, i.e. in debug builds by default.
+    // Unlike the RowView of DynMat, the row is the std::array line itself, so that it stays a reference to a plain
+    // array; that leaves the column index of m[r][c] to std::array, which only checks it in builds of the standard
+    // library with assertions (e.g. _GLIBCXX_ASSERTIONS). at(r, c) checks both
+    [[nodiscard]] constexpr const RowType &operator[](size_t r) const noexcept
     {
-        return elems.at(r);
+        static_assert(ROW_MAJOR, "rows are only contiguous in a row-major Mat");
+        detail::check_index(r, R, "row");
+        return elems.line(r);
     }
 
-    [[nodiscard]] RowType &operator[](size_t r)
+    [[nodiscard]] constexpr RowType &operator[](size_t r) noexcept
     {
-        return elems.at(r);
+        static_assert(ROW_MAJOR, "rows are only contiguous in a row-major Mat");
+        detail::check_index(r, R, "row");
+        return elems.line(r);
     }
 
+    // access (might throw)
+
     [[nodiscard]] constexpr const RowType &at(size_t r) const
     {
-        return elems.at(r);
+        return row_at(elems, r);
     }
 
-    [[nodiscard]] RowType &at(size_t r) { return elems.at(r); }
+    [[nodiscard]] constexpr RowType &at(size_t r) { return row_at(elems, r); }
 
     [[nodiscard]] constexpr const T &at(size_t r, size_t c) const
     {
-        return elems.at(r).at(c);
+        return elem_at(elems, r, c);
     }
 
-    [[nodiscard]] T &at(size_t r, size_t c) { return elems.at(r).at(c); }
+    [[nodiscard]] constexpr T &at(size_t r, size_t c) { return elem_at(elems, r, c); }
 
     // access (noexcept); prefer these, which gives compile time error if indices are out of range
     template <size_t row>
     [[nodiscard]] constexpr RowType &get() noexcept
     {
-        return std::get<row>(elems);
+        static_assert(ROW_MAJOR, "rows are only contiguous in a row-major Mat");
+        static_assert(row < ROW_COUNT, "row out of range");
+        return elems.line(row);
     }
 
     template <size_t row>
     [[nodiscard]] constexpr const RowType &get() const noexcept
     {
-        return std::get<row>(elems);
+        static_assert(ROW_MAJOR, "rows are only contiguous in a row-major Mat");
+        static_assert(row < ROW_COUNT, "row out of range");
+        return elems.line(row);
     }
 
     template <size_t row, size_t col>
     [[nodiscard]] constexpr T &get() noexcept
     {
-        return std::get<col>(get<row>());
+        static_assert(row < ROW_COUNT && col < COL_COUNT, "index out of range");
+        return elem(row, col);
     }
 
     template <size_t row, size_t col>
     [[nodiscard]] constexpr const T &get() const noexcept
     {
-        return std::get<col>(get<row>());
+        static_assert(row < ROW_COUNT && col < COL_COUNT, "index out of range");
+        return elem(row, col);
     }
 
-    [[nodiscard]] constexpr const StorageType &rows() const noexcept { return elems; }
+    /**
+     * @return the rows of a row-major Mat, for range-based for loops
+     */
+    [[nodiscard]] constexpr const StorageType &rows() const noexcept
+    {
+        static_assert(ROW_MAJOR, "rows are only contiguous in a row-major Mat");
+        return elems;
+    }
 
     /**
-     * @brief return a copy of column at Col
+     * @return the columns of a column-major Mat, for range-based for loops
+     */
+    [[nodiscard]] constexpr const StorageType &cols() const noexcept
+    {
+        static_assert(COL_MAJOR, "columns are only contiguous in a column-major Mat");
+        return elems;
+    }
+
+    /**
+     * @return pointer to element (0, 0); where the others are depends on the layout, see \ref view for strided layouts
+     */
+    [[nodiscard]] T *data() noexcept { return elems.data(); }
+
+    [[nodiscard]] const T *data() const noexcept { return elems.data(); }
+
+    /**
+     * @return this matrix as a strided operand of the gemm engine; row-major and column-major layouts only
+     */
+    [[nodiscard]] engine::StridedView<const T> view() const noexcept
+    {
+        static_assert(LayoutMap::STRIDED, "a tiled Mat has no strided view");
+        return {data(), static_cast<std::ptrdiff_t>(LayoutMap::row_stride(ld())),
+                static_cast<std::ptrdiff_t>(LayoutMap::col_stride(ld()))};
+    }
+
+    [[nodiscard]] engine::StridedView<T> view() noexcept
+    {
+        static_assert(LayoutMap::STRIDED, "a tiled Mat has no strided view");
+        return {data(), static_cast<std::ptrdiff_t>(LayoutMap::row_stride(ld())),
+                static_cast<std::ptrdiff_t>(LayoutMap::col_stride(ld()))};
+    }
+
+    /**
+     * @brief return a copy of column at Col; a contiguous copy in a column-major Mat
      * @tparam Col the column to copy
      * @return copy of a column
      */
     template <size_t Col>
     [[nodiscard]] constexpr ColType get_col() const noexcept
     {
-        return GetCol<Col>::impl(elems, std::make_index_sequence<R>());
+        static_assert(Col < COL_COUNT, "column out of range");
+        if constexpr (COL_MAJOR) {
+            return elems.line(Col);
+        } else {
+            ColType ret{};
+            for (size_t r = 0; r < R; ++r) ret[r] = elem(r, Col);
+            return ret;
+        }
+    }
+
+    /**
+     * @brief view of column c, to loop over or index at runtime; row-major and column-major layouts only
+     * @throw std::out_of_range if c >= C
+     */
+    [[nodiscard]] ColView<T> col(size_t c)
+    {
+        if (c >= C) throw std::out_of_range("column index out of range");
+        return {block_data(0, c), R, static_cast<std::ptrdiff_t>(LayoutMap::row_stride(ld()))};
+    }
+
+    [[nodiscard]] ColView<const T> col(size_t c) const
+    {
+        if (c >= C) throw std::out_of_range("column index out of range");
+        return {block_data(0, c), R, static_cast<std::ptrdiff_t>(LayoutMap::row_stride(ld()))};
     }
 
     /**
      * @brief return a tuple of length R containing references to elements at column Col
      * so far, using tuple of references to represent a "view" of a column has worked well enough; operations such as
      * iterating over the elements in a column, making a copy from the view, or modifying a column as a whole,
-     * are supported; see how \ref transpose and \ref operator* uses this
+     * are supported; \ref col is the runtime alternative, with iterators
      * @tparam Col the column to view
      * @return a tuple containing R lvalue references to column Col
      */
@@ -170,125 +609,527 @@ class Mat
         return GetColView<Col>::impl(elems, std::make_index_sequence<R>());
     }
 
-    // operators
-    [[nodiscard]] constexpr bool operator==(const ThisType &other) const noexcept
+    // operators; the padding of lines, if any, takes no part in comparisons
+    template <typename OT, typename OS, typename OL, std::enable_if_t<detail::SAME_ELEM<OT, T>, int> = 0>
+    [[nodiscard]] constexpr bool operator==(const Mat<R, C, OT, OS, OL> &other) const noexcept
     {
         // could do return elems == other.elems but libstdc++ did not implement == for arrays as constexpr :(
-        return equal(elems, other.elems, std::make_index_sequence<ROW_COUNT>());
+        for (size_t r = 0; r < R; ++r) {
+            for (size_t c = 0; c < C; ++c) {
+                if (!(elem(r, c) == other.elem(r, c))) return false;
+            }
+        }
+        return true;
     }
 
-    [[nodiscard]] constexpr bool operator!=(const ThisType &other) const noexcept { return !this->operator==(other); }
+    template <typename OT, typename OS, typename OL, std::enable_if_t<detail::SAME_ELEM<OT, T>, int> = 0>
+    [[nodiscard]] constexpr bool operator!=(const Mat<R, C, OT, OS, OL> &other) const noexcept
+    {
+        return !this->operator==(other);
+    }
 
-    template <size_t OtherC, typename E>
-    [[nodiscard]] constexpr auto operator*(const Mat<C, OtherC, E> &other) const noexcept
+    // element-wise arithmetic
+    template <typename OT, typename OS, typename OL, std::enable_if_t<detail::SAME_ELEM<OT, T>, int> = 0>
+    constexpr ThisType &operator+=(const Mat<R, C, OT, OS, OL> &other)
+    {
+        for_each_line(other, [](T *dst, const T *src, size_t n) {
+            for (size_t c = 0; c < n; ++c) dst[c] += src[c];
+        });
+        return *this;
+    }
+
+    template <typename OT, typename OS, typename OL, std::enable_if_t<detail::SAME_ELEM<OT, T>, int> = 0>
+    constexpr ThisType &operator-=(const Mat<R, C, OT, OS, OL> &other)
+    {
+        for_each_line(other, [](T *dst, const T *src, size_t n) {
+            for (size_t c = 0; c < n; ++c) dst[c] -= src[c];
+        });
+        return *this;
+    }
+
+    template <typename OT, typename OS, typename OL, std::enable_if_t<detail::SAME_ELEM<OT, T>, int> = 0>
+    [[nodiscard]] constexpr ResultType operator+(const Mat<R, C, OT, OS, OL> &other) const
+    {
+        ResultType ret(*this);
+        return ret += other;
+    }
+
+    template <typename OT, typename OS, typename OL, std::enable_if_t<detail::SAME_ELEM<OT, T>, int> = 0>
+    [[nodiscard]] constexpr ResultType operator-(const Mat<R, C, OT, OS, OL> &other) const
+    {
+        ResultType ret(*this);
+        return ret -= other;
+    }
+
+    // evaluation of lazy expressions (expr.hpp) straight into this matrix, without temporaries unless the expression
+    // reads the operands it writes to; these throw std::length_error if the shape of the expression is not R x C
+
+    template <typename Expr, std::enable_if_t<detail::IS_GEMM_EXPR<Expr>, int> = 0>
+    ThisType &operator=(const Expr &e)
+    {
+        e.assign_to(*this);
+        return *this;
+    }
+
+    template <typename Expr, std::enable_if_t<detail::IS_GEMM_EXPR<Expr>, int> = 0>
+    ThisType &operator+=(const Expr &e)
+    {
+        e.add_to(*this, T{1});
+        return *this;
+    }
+
+    template <typename Expr, std::enable_if_t<detail::IS_GEMM_EXPR<Expr>, int> = 0>
+    ThisType &operator-=(const Expr &e)
+    {
+        e.add_to(*this, T{-1});
+        return *this;
+    }
+
+    /**
+     * @brief matrix product; constexpr for any size, since compile-time evaluation always takes a plain loop
+     * the result has the storage policy and layout of this matrix. The kernel depends on the layouts: the loop runs
+     * along contiguous lines where the layouts line up, the gemm engine packs any mix of row- and column-major
+     * operands, tiled operands multiply tile by tile when their tiles fit together (Tiled<P, Q> times
+     * Tiled<Q, Q>) and Morton<TS> operands down their quadtrees; any other mix with a tiled operand goes through
+     * row-major copies
+     * @note the compiler still caps the work of one constant expression; GCC's default -fconstexpr-ops-limit fits
+     * one product of about 64 x 64 x 64 multiply-adds
+     */
+    template <size_t OtherC, typename E, typename OS, typename OL>
+    [[nodiscard]] constexpr auto operator*(const Mat<C, OtherC, E, OS, OL> &other) const
     {
         // the type of the return element should be the type produced by multiplying an instance of T with an instance
         // of E, taking promotion into account
         using RetElement = decltype(std::declval<E>() * std::declval<T>());
-        using RetType = Mat<R, OtherC, RetElement>;
 
-        // using the element-wise initialization overload
-        constexpr auto make_ret_mat = [](auto... e) {  // C++17 variadic lambda
-            static_assert(ROW_COUNT * OtherC == sizeof...(e), "must be given ROW_COUNT * OtherC elements");
-            return RetType{e...};
-        };
+        Mat<R, OtherC, RetElement, typename S::Result, L> ret;
+        ret.multiply(*this, other, true);  // ret is all zeros already
+        return ret;
+    }
+
+    /**
+     * @brief this = a * b, or this += a * b when accumulating, written straight into this matrix; unlike
+     * @c *this = a * b, no new Mat is made unless this matrix is one of the operands
+     * runs the same kernels as \ref operator*, with the layout of this matrix in place of that of the lhs; elements of
+     * a * b are converted to T. An operand sharing memory with this matrix, e.g. a view of it, is read from a copy
+     */
+    template <size_t K, typename TA, typename SA, typename LA, typename TB, typename SB, typename LB>
+    constexpr ThisType &assign_product(const Mat<R, K, TA, SA, LA> &a, const Mat<K, C, TB, SB, LB> &b,
+                                       bool accumulate = false)
+    {
+        if (shares_memory(a) || shares_memory(b)) {
+            ResultType product;
+            product.multiply(a, b, true);
+            return accumulate ? *this += product : *this = std::move(product);
+        }
+        multiply(a, b, accumulate);
+        return *this;
+    }
 
-        // C++17 apply
-        return std::apply(make_ret_mat,
-                          MulImpl<RetElement, OtherC>::build_mat(elems, other, std::make_index_sequence<R>()));
+    /**
+     * @brief this = this * other; other is square, so the shape stays
+     */
+    template <typename E, typename OS, typename OL>
+    constexpr ThisType &operator*=(const Mat<C, C, E, OS, OL> &other)
+    {
+        return assign_product(*this, other);
     }
 
     /**
      * @return return the transpose of this matrix by value
+     * at runtime, row- and column-major matrices larger than LOOP_MUL_MAX_DIM x LOOP_MUL_MAX_DIM go through
+     * engine::blocked_transpose, which moves register-sized blocks with vector shuffles for float, double and int32,
+     * and Morton matrices through engine::morton_transpose
+     */
+    [[nodiscard]] constexpr Mat<C, R, std::remove_const_t<T>, typename S::Result, L> transpose() const
+    {
+        Mat<C, R, std::remove_const_t<T>, typename S::Result, L> ret;
+        if constexpr ((ROW_MAJOR || COL_MAJOR) && R * C > LOOP_MUL_MAX_DIM * LOOP_MUL_MAX_DIM) {
+            if (!detail::is_constant_evaluated()) {
+                // line i of the result holds element i of every line of this matrix, in either layout
+                engine::blocked_transpose<std::remove_const_t<T>>(LayoutMap::LINES, LayoutMap::LEN, data(), ld(),
+                                                                  ret.data(), ret.ld());
+                return ret;
+            }
+        }
+        if constexpr (layout::detail::IS_MORTON<L>) {
+            if (!detail::is_constant_evaluated()) {
+                using Ret = decltype(ret);
+                const engine::MortonView<const T> src{data(), ld()};
+                const engine::MortonView<std::remove_const_t<T>> dst{ret.data(), ret.ld()};
+                engine::morton_transpose(LayoutMap::root(), Ret::LayoutMap::root(), L::TILE_ROWS, src, dst);
+                return ret;
+            }
+        }
+        for (size_t r = 0; r < R; ++r) {
+            for (size_t c = 0; c < C; ++c) ret.elem(c, r) = elem(r, c);
+        }
+        return ret;
+    }
+
+    /**
+     * @return a zero-copy view of the transpose of this matrix; prefer this over \ref transpose as an operand of
+     * multiplication, e.g. @c A * A.transpose_view() for a Gram matrix
      */
-    [[nodiscard]] constexpr Mat<C, R, T> transpose() const noexcept
+    [[nodiscard]] constexpr TransposeView<ThisType> transpose_view() const & noexcept
     {
-        return transpose_impl(std::make_index_sequence<C>());
+        return TransposeView<ThisType>{*this};
+    }
+
+    TransposeView<ThisType> transpose_view() const && = delete;  ///< the view would dangle
+
+    /**
+     * @brief this = this^T without a second matrix; square matrices only, since the type fixes the shape (a DynMat of
+     * any shape transposes in place too)
+     * at runtime, row- and column-major matrices larger than LOOP_MUL_MAX_DIM x LOOP_MUL_MAX_DIM swap blocks mirrored
+     * across the diagonal through engine::square_transpose_in_place
+     */
+    constexpr ThisType &transpose_in_place() noexcept
+    {
+        static_assert(R == C, "only square Mats transpose in place");
+        static_assert(!std::is_const_v<T>, "the elements must be writable");
+        if constexpr ((ROW_MAJOR || COL_MAJOR) && R * C > LOOP_MUL_MAX_DIM * LOOP_MUL_MAX_DIM) {
+            if (!detail::is_constant_evaluated()) {
+                engine::square_transpose_in_place(R, data(), ld());
+                return *this;
+            }
+        }
+        for (size_t r = 0; r < R; ++r) {
+            for (size_t c = r + 1; c < C; ++c) {
+                T tmp = elem(r, c);
+                elem(r, c) = elem(c, r);
+                elem(c, r) = tmp;
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * @brief BR x BC view of the block whose top-left element is (R0, C0), aliasing the elements of this matrix;
+     * an operand or an output like any other Mat, so blocked algorithms update panels in place, e.g. the trailing
+     * update of an LU factorization:
+     * @code
+     * auto a22 = a.block<4, 4, 4, 4>();
+     * a22 -= a.block<4, 0, 4, 4>() * a.block<0, 4, 4, 4>();
+     * @endcode
+     * row-major and column-major layouts only; blocks of blocks work too
+     */
+    template <size_t R0, size_t C0, size_t BR, size_t BC>
+    [[nodiscard]] Mat<BR, BC, T, storage::Ref, L> block() noexcept
+    {
+        static_assert(R0 + BR <= R && C0 + BC <= C, "block out of range");
+        return Mat<BR, BC, T, storage::Ref, L>(block_data(R0, C0), ld());
+    }
+
+    template <size_t R0, size_t C0, size_t BR, size_t BC>
+    [[nodiscard]] Mat<BR, BC, const T, storage::Ref, L> block() const noexcept
+    {
+        static_assert(R0 + BR <= R && C0 + BC <= C, "block out of range");
+        return Mat<BR, BC, const T, storage::Ref, L>(block_data(R0, C0), ld());
+    }
+
+    /**
+     * @brief br x bc view of the block whose top-left element is (r0, c0), for blocks only known at runtime; see
+     * \ref block. Row-major only; the view is a MatMap, so this takes dyn_matrix.hpp (a template, so that the
+     * incomplete MatMap is a compile error rather than a missing symbol without it)
+     * @throw std::out_of_range if the block does not fit in this matrix
+     */
+    template <typename Map = MatMap<T>>
+    [[nodiscard]] Map block(size_t r0, size_t c0, size_t br, size_t bc)
+    {
+        static_assert(ROW_MAJOR, "runtime blocks are views of row-major matrices");
+        detail::check_block(R, C, r0, c0, br, bc);
+        return Map(block_data(r0, c0), br, bc, ld());
+    }
+
+    template <typename Map = MatMap<const T>>
+    [[nodiscard]] Map block(size_t r0, size_t c0, size_t br, size_t bc) const
+    {
+        static_assert(ROW_MAJOR, "runtime blocks are views of row-major matrices");
+        detail::check_block(R, C, r0, c0, br, bc);
+        return Map(block_data(r0, c0), br, bc, ld());
     }
-    // TODO maybe it's also possible to return a view of the transpose of this matrix?
 
     // special functions; for demo
-    static constexpr ThisType zeros() noexcept { return ThisType{0}; }
+    static constexpr ThisType zeros() { return ThisType{0}; }
 
-    static constexpr Mat<R, R, T> identity() noexcept
+    static constexpr Mat<R, R, T, S, L> identity()
     {
         static_assert(ROW_COUNT == COL_COUNT, "only defined for square matrices");
-        Mat<R, R, T> ret{0};
-        ret.fill_diagonal(T{1}, std::make_index_sequence<R>());
+        Mat<R, R, T, S, L> ret;
+        for (size_t r = 0; r < R; ++r) ret.elem(r, r) = T{1};
         return ret;
     }
 
    private:
-    template <size_t OR, size_t OC, typename OT>
+    template <size_t OR, size_t OC, typename OT, typename OS, typename OL>
     friend class Mat;  ///< for ease of interoperability with another instance of this class
 
-    StorageType elems{0};  ///< row-major 2D array, defaults to zero-initialized
+    StorageType elems{};  ///< lines of elements as cut by the layout and laid out by the storage policy; zeroed
+
+    /// how many elements of each line loops may touch: the line and, at runtime, padding this matrix owns
+    constexpr static size_t WIDTH = StorageType::WIDTH;
 
     /**
-     * @brief fill the (main) diagonal with a given value
-     * @tparam Rows usually ROW_COUNT
-     * @param val the value to fill with
+     * @brief element (r, c) of buffer, a StorageType of any Mat with this layout; no bounds checking
      */
-    template <size_t... Rows>
-    constexpr void fill_diagonal(T val, std::index_sequence<Rows...>) noexcept
+    template <typename Buffer>
+    [[nodiscard]] static constexpr auto &slot(Buffer &buffer, size_t r, size_t c) noexcept
     {
-        ((std::get<Rows>(std::get<Rows>(elems)) = val), ...);  // C++17 fold expression
+        return buffer.line_data(LayoutMap::line(r, c))[LayoutMap::offset(r, c)];
     }
 
     /**
-     * @brief unpacks an initializer list to make a row
-     * @tparam Cols usually COL_COUNT
-     * @param l an initializer list
-     * @return a row with elements from l, in the order they appear
+     * @brief where a block with top-left element (r0, c0) starts; strided layouts only
      */
-    template <size_t... Cols>
-    constexpr RowType make_row(std::initializer_list<T> &&l, std::index_sequence<Cols...>)
+    [[nodiscard]] T *block_data(size_t r0, size_t c0) noexcept
     {
-        return {(*std::next(std::begin(std::move(l)), Cols))...};
+        static_assert(LayoutMap::STRIDED, "a block of a tiled Mat is not strided");
+        return data() + r0 * LayoutMap::row_stride(ld()) + c0 * LayoutMap::col_stride(ld());
+    }
+
+    [[nodiscard]] const T *block_data(size_t r0, size_t c0) const noexcept
+    {
+        static_assert(LayoutMap::STRIDED, "a block of a tiled Mat is not strided");
+        return data() + r0 * LayoutMap::row_stride(ld()) + c0 * LayoutMap::col_stride(ld());
     }
 
     /**
-     * @brief return a tuple containing references to each row
-     * @tparam Rows usually ROW_COUNT
-     * @return tuple containing lvalue references to rows in elems
+     * @brief whether m is this very matrix
      */
-    template <size_t... Rows>
-    constexpr auto rows(std::index_sequence<Rows...>)
+    template <typename M>
+    [[nodiscard]] constexpr bool is_same_object(const M &m) const noexcept
     {
-        return std::forward_as_tuple(std::get<Rows>(elems)...);
+        return static_cast<const void *>(&m) == static_cast<const void *>(this);
     }
 
-    template <typename... L>
-    constexpr void row_wise_init(std::initializer_list<L> &&... l)
+    /**
+     * @brief whether the elements of m and those of this matrix may overlap in memory, as a view and the matrix it
+     * views do; at compile time, where there are no views, whether m is this very matrix
+     */
+    template <typename M>
+    [[nodiscard]] constexpr bool shares_memory(const M &m) const noexcept
     {
-        constexpr auto seq = std::index_sequence_for<L...>();
-        rows(seq) = std::forward_as_tuple(make_row(std::move(l), std::make_index_sequence<C>())...);
+        if (detail::is_constant_evaluated()) return is_same_object(m);
+        const auto range = [](const auto &x) {
+            using X = std::decay_t<decltype(x)>;
+            const auto *first = reinterpret_cast<const char *>(x.data());
+            const size_t last = (X::LayoutMap::LINES - 1) * x.ld() + X::LayoutMap::LEN;
+            return std::make_pair(first, first + last * sizeof(typename X::ElemType));
+        };
+        const auto [lo, hi] = range(*this);
+        const auto [m_lo, m_hi] = range(m);
+        return std::less<>{}(lo, m_hi) && std::less<>{}(m_lo, hi);
     }
 
-    template <size_t... idx>
-    constexpr Mat<C, R, T> transpose_impl(std::index_sequence<idx...>) const noexcept
+    /**
+     * @brief set every element, padding within lines included, to zero
+     */
+    constexpr void zero() noexcept
     {
-        constexpr auto make_transpose_mat = [](auto... e) { return Mat<C, R, T>{e...}; };  // C++17 variadic lambdas
-        return std::apply(make_transpose_mat, std::tuple_cat(col_view<idx>()...));
+        for (size_t i = 0; i < LayoutMap::LINES; ++i) {
+            T *line = elems.line_data(i);
+            for (size_t j = 0; j < WIDTH; ++j) line[j] = T{};
+        }
     }
 
     /**
-     * @brief helper struct to get a copy of a column
-     * Can't have get_impl take in both a size_t template param and a size_t... param pack, so passing Col via the
-     * template params of this struct
-     * @tparam Col the column to get
+     * @brief this = a * b, or this += a * b when accumulating; neither a nor b may be this matrix
+     * see \ref operator* for the choice of kernel
      */
-    template <size_t Col>
-    struct GetCol final {
-        GetCol() = delete;  ///< don't bother generating special functions
+    template <size_t K, typename TA, typename SA, typename LA, typename TB, typename SB, typename LB>
+    constexpr void multiply(const Mat<R, K, TA, SA, LA> &a, const Mat<K, C, TB, SB, LB> &b, bool accumulate)
+    {
+        using AType = Mat<R, K, TA, SA, LA>;
+        using BType = Mat<K, C, TB, SB, LB>;
 
-        template <typename SType, size_t... idx>
-        [[nodiscard]] static constexpr ColType impl(SType &&storage, std::index_sequence<idx...>) noexcept
-        {
-            static_assert(COL_COUNT == sizeof...(idx), "should be getting exactly COL_COUNT elements");
-            return {std::get<Col>(std::get<idx>(std::forward<SType>(storage)))...};
+        constexpr bool small = R <= LOOP_MUL_MAX_DIM && K <= LOOP_MUL_MAX_DIM && C <= LOOP_MUL_MAX_DIM;
+        if (small || detail::is_constant_evaluated()) {
+            if (!accumulate) zero();
+            // the innermost loop runs along lines of both this and one operand; plain pointers there also keep the
+            // operation count of compile-time evaluation down. At runtime the loop also covers the padding both lines
+            // share, if any, so it runs over whole vectors: padding only ever flows into padding
+            if constexpr (ROW_MAJOR && BType::ROW_MAJOR) {
+                // i-k-j: rows of b into rows of this
+                const size_t width = detail::is_constant_evaluated() ? C : std::min(WIDTH, BType::WIDTH);
+                for (size_t r = 0; r < R; ++r) {
+                    T *out = elems.line_data(r);
+                    for (size_t k = 0; k < K; ++k) {
+                        const TA x = a.elem(r, k);
+                        const TB *in = b.elems.line_data(k);
+                        for (size_t c = 0; c < width; ++c) out[c] += x * in[c];
+                    }
+                }
+            } else if constexpr (COL_MAJOR && AType::COL_MAJOR) {
+                // j-k-i: columns of a into columns of this
+                const size_t width = detail::is_constant_evaluated() ? R : std::min(WIDTH, AType::WIDTH);
+                for (size_t c = 0; c < C; ++c) {
+                    T *out = elems.line_data(c);
+                    for (size_t k = 0; k < K; ++k) {
+                        const TB y = b.elem(k, c);
+                        const TA *in = a.elems.line_data(k);
+                        for (size_t r = 0; r < width; ++r) out[r] += in[r] * y;
+                    }
+                }
+            } else {
+                for (size_t r = 0; r < R; ++r) {
+                    for (size_t k = 0; k < K; ++k) {
+                        const TA x = a.elem(r, k);
+                        for (size_t c = 0; c < C; ++c) elem(r, c) += x * b.elem(k, c);
+                    }
+                }
+            }
+        } else if constexpr (LayoutMap::STRIDED && AType::LayoutMap::STRIDED && BType::LayoutMap::STRIDED) {
+            engine::gemm(R, C, K, T{1}, a.view(), b.view(), accumulate ? T{1} : T{}, view());
+        } else if constexpr (std::is_same_v<L, LA> && layout::detail::TILES_FIT<LA, LB>) {
+            if (!accumulate) zero();
+            constexpr size_t TM = LA::TILE_ROWS;
+            constexpr size_t TK = LA::TILE_COLS;
+            const engine::TiledView<const TA> va{a.data(), AType::LayoutMap::COL_TILES, a.ld()};
+            const engine::TiledView<const TB> vb{b.data(), BType::LayoutMap::COL_TILES, b.ld()};
+            const engine::TiledView<T> vc{data(), LayoutMap::COL_TILES, ld()};
+            engine::tiled_gemm(LayoutMap::ROW_TILES, K, TM, TK, TK, va, vb, vc);
+        } else if constexpr (layout::detail::IS_MORTON<L> && std::is_same_v<L, LA> && std::is_same_v<L, LB>) {
+            if (!accumulate) zero();
+            constexpr size_t TS = L::TILE_ROWS;
+            const engine::MortonView<const TA> va{a.data(), a.ld()};
+            const engine::MortonView<const TB> vb{b.data(), b.ld()};
+            const engine::MortonView<T> vc{data(), ld()};
+            engine::morton_gemm(AType::LayoutMap::root(), BType::LayoutMap::root(), LayoutMap::root(), K, TS, va, vb,
+                                vc);
+        } else if constexpr (LayoutMap::STRIDED) {
+            // tiles that don't fit together: multiply row-major copies of the tiled operands
+            using A = std::conditional_t<AType::LayoutMap::STRIDED, const AType &, Mat<R, K, TA, typename SA::Result>>;
+            using B = std::conditional_t<BType::LayoutMap::STRIDED, const BType &, Mat<K, C, TB, typename SB::Result>>;
+            multiply(static_cast<A>(a), static_cast<B>(b), accumulate);
+        } else {
+            Mat<R, C, T, typename S::Result> product;
+            product.multiply(a, b, true);
+            if (accumulate) {
+                *this += product;
+            } else {
+                *this = product;
+            }
         }
-    };
+    }
+
+    /**
+     * @brief element (r, c); no bounds checking
+     */
+    [[nodiscard]] constexpr T &elem(size_t r, size_t c) noexcept { return slot(elems, r, c); }
+
+    [[nodiscard]] constexpr const T &elem(size_t r, size_t c) const noexcept { return slot(elems, r, c); }
+
+    /**
+     * @brief row r, or std::out_of_range
+     */
+    template <typename Buffer>
+    [[nodiscard]] static constexpr auto &row_at(Buffer &buffer, size_t r)
+    {
+        static_assert(ROW_MAJOR, "rows are only contiguous in a row-major Mat");
+        if (r >= R) throw std::out_of_range("row index out of range");
+        return buffer.line(r);
+    }
+
+    /**
+     * @brief element (r, c), or std::out_of_range
+     */
+    template <typename Buffer>
+    [[nodiscard]] static constexpr auto &elem_at(Buffer &buffer, size_t r, size_t c)
+    {
+        if (r >= R) throw std::out_of_range("row index out of range");
+        if (c >= C) throw std::out_of_range("column index out of range");
+        return slot(buffer, r, c);
+    }
+
+    /**
+     * @brief call f(dst, src, n) on runs of n matching elements of this matrix and other
+     * with the same layout, the runs are lines: n is the line length at compile time, and at runtime also covers the
+     * padding the two matrices own, so that f runs over whole vectors. Otherwise the runs are single elements. When
+     * other is a view overlapping this matrix elsewhere than at the same elements, it is copied first
+     * @throw std::bad_alloc if the arena can't grow for that copy
+     */
+    template <typename OT, typename OS, typename OL, typename F>
+    constexpr void for_each_line(const Mat<R, C, OT, OS, OL> &other, F &&f)
+    {
+        if (!detail::is_constant_evaluated() && !is_same_object(other) && shares_memory(other)) {
+            // e.g. two views of one buffer, a line apart: writing a line of one would change a line of the other
+            for_each_line_of_copy(other, std::forward<F>(f));
+            return;
+        }
+        if constexpr (std::is_same_v<OL, L>) {
+            constexpr size_t OTHER_WIDTH = Mat<R, C, OT, OS, OL>::WIDTH;
+            const size_t width = detail::is_constant_evaluated() ? LayoutMap::LEN : std::min(WIDTH, OTHER_WIDTH);
+            for (size_t i = 0; i < LayoutMap::LINES; ++i) f(elems.line_data(i), other.elems.line_data(i), width);
+        } else {
+            for (size_t r = 0; r < R; ++r) {
+                for (size_t c = 0; c < C; ++c) f(&elem(r, c), &other.elem(r, c), 1);
+            }
+        }
+    }
+
+    /**
+     * @brief \ref for_each_line over a copy of other in scratch memory of the arena, lines back to back
+     */
+    template <typename OT, typename OS, typename OL, typename F>
+    void for_each_line_of_copy(const Mat<R, C, OT, OS, OL> &other, F &&f)
+    {
+        using Copy = Mat<R, C, std::remove_const_t<OT>, storage::Ref, OL>;
+        arena::Buffer<std::remove_const_t<OT>> scratch(Copy::LayoutMap::LINES * Copy::LayoutMap::LEN);
+        Copy copy(scratch.data());
+        copy.copy_from(other);
+        for_each_line(copy, std::forward<F>(f));
+    }
+
+    /**
+     * @brief copy the elements of other into this matrix
+     */
+    template <typename OT, typename OS, typename OL>
+    constexpr void copy_from(const Mat<R, C, OT, OS, OL> &other)
+    {
+        for_each_line(other, [](T *dst, const T *src, size_t n) {
+            for (size_t c = 0; c < n; ++c) dst[c] = src[c];
+        });
+    }
+
+    /**
+     * @brief the storage for the variadic constructor: every element set to e when given a single argument,
+     * otherwise the elements in row-major order
+     */
+    template <typename... E>
+    [[nodiscard]] static constexpr StorageType make_storage(E &&... e)
+    {
+        StorageType ret{};
+        if constexpr (sizeof...(E) == 1 && ELEM_COUNT != 1) {
+            const T value(std::forward<E>(e)...);
+            for (size_t r = 0; r < R; ++r) {
+                for (size_t c = 0; c < C; ++c) slot(ret, r, c) = value;
+            }
+        } else {
+            const T values[ELEM_COUNT]{std::forward<E>(e)...};
+            for (size_t r = 0; r < R; ++r) {
+                for (size_t c = 0; c < C; ++c) slot(ret, r, c) = values[r * C + c];
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * @brief copy the elements of an initializer list into row r, in the order they appear
+     */
+    template <typename E>
+    constexpr void init_row(size_t r, const std::initializer_list<E> &l)
+    {
+        size_t c = 0;
+        for (const E &e : l) elem(r, c++) = e;
+    }
+
+    template <typename... E>
+    constexpr void row_wise_init(std::initializer_list<E> &&... l)
+    {
+        size_t r = 0;
+        (init_row(r++, l), ...);  // C++17 fold expression
+    }
 
     template <size_t Col>
     struct GetColView final {
@@ -303,108 +1144,77 @@ class Mat
          * storage
          */
         template <typename SType, size_t... Rows>
-        static constexpr auto impl(SType &&storage, std::index_sequence<Rows...>) noexcept
+        static constexpr auto impl(SType &storage, std::index_sequence<Rows...>) noexcept
         {
-            return std::forward_as_tuple(std::get<Col>(std::get<Rows>(std::forward<SType>(storage)))...);
+            return std::forward_as_tuple(slot(storage, Rows, Col)...);
         }
     };
+};
 
-    template <typename ElemType, size_t OCol>
-    struct MulImpl final {
-        MulImpl() = delete;  ///< don't bother generating special functions
+/**
+ * @brief non-owning R x C view of elements owned by someone else, e.g. a buffer from another library or a block of a
+ * larger matrix; every line (row, for the default layout) is contiguous, and lines sit a runtime leading dimension
+ * apart:
+ * @code
+ * float buffer[4 * 16];
+ * MatRef<4, 3, float> m(buffer + 2, 16);  // columns 2 to 4 of a 4 x 16 row-major matrix
+ * m = a * b;                              // writes the product into buffer
+ * @endcode
+ * takes part in every operation a Mat does, with the fast kernels where its layout allows; results are owning Mats on
+ * the heap. Copies view the same elements, while assignment writes the viewed elements. A MatRef of const T is
+ * read-only
+ */
+template <size_t R, size_t C = R, typename T = int, typename L = layout::RowMajor>
+using MatRef = Mat<R, C, T, storage::Ref, L>;
 
-        /**
-         * @brief constexpr dot product of two arrays of same length
-         * @tparam OtherCol type of a col from the rhs matrix
-         * @tparam Cols param pact of the same length as other_col
-         * @param this_row a row form the lhs matrix, should have length C
-         * @param other_col a col from the rhs matrix, should have length C
-         * @return the inner product of this_row and other_col, with type promotion as necessary
-         */
-        template <typename OtherCol, size_t... Cols>
-        [[nodiscard]] constexpr static ElemType inner_product(const RowType &this_row, const OtherCol &other_col,
-                                                              std::index_sequence<Cols...>) noexcept
-        {
-            constexpr auto accumulate = [](auto... e) -> ElemType {  // C++17 variadic lambda
-                return (e + ...);  // sum all elements of a param pack; C++17 fold expression
-            };
-            return std::apply(accumulate,
-                              std::forward_as_tuple(std::get<Cols>(this_row) * std::get<Cols>(other_col)...));
-        }
+/**
+ * @brief out = a * b, or out += a * b when accumulating, without making a new Mat; see Mat::assign_product
+ */
+template <size_t R, size_t C, typename T, typename S, typename L, typename A, typename B>
+constexpr Mat<R, C, T, S, L> &gemm_into(Mat<R, C, T, S, L> &out, const A &a, const B &b, bool accumulate = false)
+{
+    return out.assign_product(a, b, accumulate);
+}
 
-        /**
-         * @brief build one row of the output matrix
-         * @tparam Row the row to build
-         * @tparam OtherMat type of the rhs matrix
-         * @tparam OCols number of columns in the output matrix
-         * @param this_storage the underlying 2D array in the lhs matrix
-         * @param other_matt he underlying 2D array in the rhs matrix
-         * @return tuple containing R counts of ElemType
-         */
-        template <size_t Row, typename OtherMat, size_t... OCols>
-        [[nodiscard]] constexpr static auto build_row(const StorageType &this_storage, const OtherMat &other_mat,
-                                                      std::index_sequence<OCols...>) noexcept
-        {
-            return std::make_tuple(inner_product(std::get<Row>(this_storage),
-                                                 other_mat.template col_view<OCols>(),  // C++ template disambiguator
-                                                 std::make_index_sequence<C>())...);
-        }
+namespace detail
+{
+/**
+ * @brief run the gemm engine on two operands of compatible shapes into a new R x N Mat
+ * @tparam T element type of the lhs
+ * @tparam E element type of the rhs
+ */
+template <size_t R, size_t N, typename T, typename E, typename S, typename L, typename AView, typename BView>
+[[nodiscard]] auto mat_product(size_t k, const AView &a, const BView &b)
+{
+    // same promotion rule as Mat::operator*
+    using RetElement = decltype(std::declval<E>() * std::declval<T>());
+    Mat<R, N, RetElement, typename S::Result, L> ret;
+    engine::gemm(R, N, k, RetElement{1}, a, b, RetElement{}, ret.view());
+    return ret;
+}
+}  // namespace detail
 
-        /**
-         * @brief build a tuple of ElemType, containing R * OCol elements that shall be used to element-wise construct a
-         * Mat<Rows, OCol, ElemType>
-         * @tparam OtherMat type of the rhs matrix
-         * @tparam Rows number of rows in the output matrix; should be R
-         * @param this_storage the underlying 2D array in the lhs matrix
-         * @param other_mat underlying 2D array in the rhs matrix
-         * @return tuple containing R * OCol counts of ElemType
-         */
-        template <typename OtherMat, size_t... Rows>
-        [[nodiscard]] constexpr static auto build_mat(const StorageType &this_storage, const OtherMat &other_mat,
-                                                      std::index_sequence<Rows...>) noexcept
-        {
-            static_assert(COL_COUNT == OtherMat::ROW_COUNT,
-                          "the other matrix should have the same number of rows as the columns in this matrix");
-            return std::tuple_cat(build_row<Rows>(this_storage, other_mat, std::make_index_sequence<OCol>())...);
-        }
-    };
+// products with transposed operands; the lhs is R x C and the rhs is C x N in every one of them, and the result has
+// the storage policy and layout of the (viewed) lhs. Row-major and column-major operands only
 
-    /**
-     * @brief the implementation of \ref row_equal
-     */
-    template <size_t... Cols>
-    static constexpr bool row_equal_impl(const RowType &self, const RowType &other,
-                                         std::index_sequence<Cols...>) noexcept
-    {
-        return ((std::get<Cols>(self) == std::get<Cols>(other)) && ...);  // C++17 fold expression
-    }
+template <size_t R, size_t C, typename T, typename S, typename L, size_t N, typename E, typename OS, typename OL>
+[[nodiscard]] auto operator*(const Mat<R, C, T, S, L> &lhs, const TransposeView<Mat<N, C, E, OS, OL>> &rhs)
+{
+    return detail::mat_product<R, N, T, E, S, L>(C, lhs.view(), rhs.view());
+}
 
-    /**
-     * @brief check if two rows are equal;
-     * @tparam Row the row to compare
-     * @param self storage of the lhs of operator==
-     * @param other storage of the rhs of operator==
-     * @return true if every element in row Row of self is equal to the element in the corresponding position in other
-     */
-    template <size_t Row>
-    static constexpr bool row_equal(const StorageType &self, const StorageType &other) noexcept
-    {
-        return row_equal_impl(std::get<Row>(self), std::get<Row>(other), std::make_index_sequence<C>());
-    }
+template <size_t R, size_t C, typename T, typename S, typename L, size_t N, typename E, typename OS, typename OL>
+[[nodiscard]] auto operator*(const TransposeView<Mat<C, R, T, S, L>> &lhs, const Mat<C, N, E, OS, OL> &rhs)
+{
+    return detail::mat_product<R, N, T, E, S, L>(C, lhs.view(), rhs.view());
+}
 
-    /**
-     * @brief check if all the rows in self are equal to all the rows in other
-     * @tparam Rows usually ROW_COUNT
-     * @param self storage of the lhs of operator==
-     * @param other storage of the rhs of operator==
-     * @return true if all the rows in self are equal to all the rows in other; false otherwise
-     */
-    template <size_t... Rows>
-    static constexpr bool equal(const StorageType &self, const StorageType &other, std::index_sequence<Rows...>)
-    {
-        return ((row_equal<Rows>(self, other)) && ...);  // C++17 fold expression
-    }
-};
+template <size_t R, size_t C, typename T, typename S, typename L, size_t N, typename E, typename OS, typename OL>
+[[nodiscard]] auto operator*(const TransposeView<Mat<C, R, T, S, L>> &lhs,
+                             const TransposeView<Mat<N, C, E, OS, OL>> &rhs)
+{
+    return detail::mat_product<R, N, T, E, S, L>(C, lhs.view(), rhs.view());
+}
 
 }  // namespace toy_gemm
 
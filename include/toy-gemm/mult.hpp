@@ -0,0 +1,96 @@
+#ifndef TOY_GEMM_MULT_HPP
+#define TOY_GEMM_MULT_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "dyn_matrix.hpp"
+#include "gemm.hpp"
+#include "matrix.hpp"
+
+/**
+ * Multiplication policies: alternative engines for products of \ref Mat, \ref DynMat and \ref MatMap, picked per call
+ * through \ref multiply:
+ * @code
+ * auto c = multiply(a, b, mult::Blocked{});  // same as a * b
+ * @endcode
+ * A policy is a type P with mult::detail::IS_POLICY<P> and an overload engine::gemm(const P &, m, n, k, alpha, a, b,
+ * beta, c) of the BLAS-style engine entry point; strassen.hpp and recursive.hpp add the others
+ */
+
+namespace toy_gemm
+{
+namespace mult
+{
+/**
+ * @brief the cache-blocked engine of gemm.hpp, i.e. what operator* runs
+ */
+struct Blocked final {
+};
+
+namespace detail
+{
+template <typename P>
+constexpr bool IS_POLICY = false;
+
+template <>
+constexpr bool IS_POLICY<Blocked> = true;
+}  // namespace detail
+}  // namespace mult
+
+namespace engine
+{
+/**
+ * @brief C := alpha * A * B + beta * C with the blocked engine; see the policy-free \ref gemm
+ */
+template <typename T, typename AView, typename BView>
+void gemm(const mult::Blocked &, size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta,
+          const StridedView<T> &c)
+{
+    gemm(m, n, k, alpha, a, b, beta, c);
+}
+}  // namespace engine
+
+/**
+ * @brief a * b with the given multiplication policy; the result is the same Mat that a * b makes
+ * @tparam P a multiplication policy, e.g. mult::Blocked
+ */
+template <typename P, size_t R, size_t K, size_t C, typename T, typename S, typename L, typename E, typename OS,
+          typename OL, std::enable_if_t<mult::detail::IS_POLICY<P>, int> = 0>
+[[nodiscard]] auto multiply(const Mat<R, K, T, S, L> &a, const Mat<K, C, E, OS, OL> &b, const P &policy)
+{
+    using RetElement = decltype(std::declval<E>() * std::declval<T>());
+    using Ret = Mat<R, C, RetElement, typename S::Result, L>;
+    if constexpr (!Mat<R, K, T, S, L>::LayoutMap::STRIDED) {
+        // tiled operands multiply through row-major copies
+        return Ret(multiply(Mat<R, K, std::remove_const_t<T>, typename S::Result>(a), b, policy));
+    } else if constexpr (!Mat<K, C, E, OS, OL>::LayoutMap::STRIDED) {
+        return multiply(a, Mat<K, C, std::remove_const_t<E>, typename OS::Result>(b), policy);
+    } else {
+        Ret ret;
+        // unqualified, so the overload of a policy declared after this header is found too, by ADL on the views
+        gemm(policy, R, C, K, RetElement{1}, a.view(), b.view(), RetElement{}, ret.view());
+        return ret;
+    }
+}
+
+/**
+ * @brief a * b with the given multiplication policy, for DynMat and MatMap operands; the result is a DynMat
+ * @tparam P a multiplication policy, e.g. mult::Blocked
+ * @throw std::length_error if the inner dimensions differ
+ */
+template <typename P, typename X, typename Y,
+          std::enable_if_t<mult::detail::IS_POLICY<P> && detail::IS_DYN<X> && detail::IS_DYN<Y>, int> = 0>
+[[nodiscard]] auto multiply(const X &a, const Y &b, const P &policy)
+{
+    if (a.col_count() != b.row_count()) throw std::length_error("inner dimensions must agree");
+    using RetElement = decltype(std::declval<typename Y::ElemType>() * std::declval<typename X::ElemType>());
+    DynMat<RetElement> ret(a.row_count(), b.col_count());
+    gemm(policy, a.row_count(), b.col_count(), a.col_count(), RetElement{1}, a.view(), b.view(), RetElement{},
+         ret.view());
+    return ret;
+}
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_MULT_HPP
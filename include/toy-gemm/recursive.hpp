@@ -0,0 +1,217 @@
+#ifndef TOY_GEMM_RECURSIVE_HPP
+#define TOY_GEMM_RECURSIVE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "gemm.hpp"
+#include "mult.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Cache-oblivious algorithms. Instead of cutting the work into blocks sized for the caches of one machine, they halve
+ * the largest dimension until the pieces are small, so at some depth the working set fits whichever cache level
+ * there is, without knowing its size (Frigo, Leiserson, Prokop & Ramachandran, 1999):
+ * @code
+ * auto c = multiply(a, b, mult::Recursive{});  // a and b: Mats, DynMats or MatMaps
+ * auto t = transpose(a, mult::Recursive{});    // same result as a.transpose()
+ * @endcode
+ * The base case of the product is the packed microkernel of the blocked engine on pieces of at most
+ * RECURSIVE_BASE_DIM rows, columns and depth; the base case of the transpose is a plain loop over at most
+ * RECURSIVE_TRANSPOSE_BASE elements
+ */
+
+namespace toy_gemm
+{
+namespace mult
+{
+/**
+ * @brief cache-oblivious divide and conquer on the largest dimension
+ */
+struct Recursive final {
+};
+
+namespace detail
+{
+template <>
+constexpr bool IS_POLICY<Recursive> = true;
+}  // namespace detail
+}  // namespace mult
+
+namespace engine
+{
+constexpr size_t RECURSIVE_BASE_DIM = 128;            ///< no dimension of a base-case product is larger than this
+constexpr size_t RECURSIVE_TRANSPOSE_BASE = 32 * 32;  ///< base-case transposes move at most this many elements
+
+namespace detail
+{
+/**
+ * @brief a view of v that starts at (r0, c0); a StridedView for a StridedView
+ */
+template <typename View>
+struct Shifted {
+    const View &v;
+    size_t r0;
+    size_t c0;
+
+    [[nodiscard]] decltype(auto) operator()(size_t r, size_t c) const { return v(r0 + r, c0 + c); }
+};
+
+template <typename View>
+[[nodiscard]] Shifted<View> shifted(const View &v, size_t r0, size_t c0) noexcept
+{
+    return {v, r0, c0};
+}
+
+template <typename T>
+[[nodiscard]] StridedView<T> shifted(const StridedView<T> &v, size_t r0, size_t c0) noexcept
+{
+    return {&v(r0, c0), v.row_stride, v.col_stride};
+}
+
+/**
+ * @brief the m x n x k product at (i0, j0, p0): C[i0.., j0..] := alpha * A[i0.., p0..] * B[p0.., j0..] + beta * C
+ * splits the largest of m, n and k in half; the two halves of k run one after the other, the second one
+ * accumulating onto the first
+ */
+template <typename T, typename AView, typename BView>
+void recursive_gemm(size_t i0, size_t j0, size_t p0, size_t m, size_t n, size_t k, T alpha, const AView &a,
+                    const BView &b, T beta, const StridedView<T> &c, const MicroKernel<T> &kernel)
+{
+    if (std::max({m, n, k}) <= RECURSIVE_BASE_DIM) {
+        gemm_block(i0, j0, m, n, k, alpha, shifted(a, 0, p0), shifted(b, p0, 0), beta, c, kernel);
+    } else if (m >= n && m >= k) {
+        const size_t h = m / 2;
+        recursive_gemm(i0, j0, p0, h, n, k, alpha, a, b, beta, c, kernel);
+        recursive_gemm(i0 + h, j0, p0, m - h, n, k, alpha, a, b, beta, c, kernel);
+    } else if (n >= k) {
+        const size_t h = n / 2;
+        recursive_gemm(i0, j0, p0, m, h, k, alpha, a, b, beta, c, kernel);
+        recursive_gemm(i0, j0 + h, p0, m, n - h, k, alpha, a, b, beta, c, kernel);
+    } else {
+        const size_t h = k / 2;
+        recursive_gemm(i0, j0, p0, m, n, h, alpha, a, b, beta, c, kernel);
+        recursive_gemm(i0, j0, p0 + h, m, n, k - h, alpha, a, b, T{1}, c, kernel);
+    }
+}
+
+/**
+ * @brief a block of C that one task of a parallel recursive product computes
+ */
+struct Tile {
+    size_t i0;
+    size_t j0;
+    size_t m;
+    size_t n;
+};
+
+/**
+ * @brief cut the m x n block at (i0, j0) in halves of the larger dimension, each cut going into tiles, until there are
+ * count tiles or the pieces reach RECURSIVE_BASE_DIM
+ */
+inline void split_tiles(size_t i0, size_t j0, size_t m, size_t n, size_t count, std::vector<Tile> &tiles)
+{
+    if (count <= 1 || std::max(m, n) <= RECURSIVE_BASE_DIM) {
+        tiles.push_back({i0, j0, m, n});
+    } else if (m >= n) {
+        split_tiles(i0, j0, m / 2, n, count / 2, tiles);
+        split_tiles(i0 + m / 2, j0, m - m / 2, n, count - count / 2, tiles);
+    } else {
+        split_tiles(i0, j0, m, n / 2, count / 2, tiles);
+        split_tiles(i0, j0 + n / 2, m, n - n / 2, count - count / 2, tiles);
+    }
+}
+
+/**
+ * @brief dst := src^T for an m x n src; splits the larger dimension in half
+ */
+template <typename T, typename E>
+void recursive_transpose(size_t m, size_t n, const StridedView<E> &src, const StridedView<T> &dst)
+{
+    if (m * n <= RECURSIVE_TRANSPOSE_BASE) {
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) dst(j, i) = src(i, j);
+        }
+    } else if (m >= n) {
+        const size_t h = m / 2;
+        recursive_transpose(h, n, src, dst);
+        recursive_transpose(m - h, n, shifted(src, h, 0), shifted(dst, 0, h));
+    } else {
+        const size_t h = n / 2;
+        recursive_transpose(m, h, src, dst);
+        recursive_transpose(m, n - h, shifted(src, 0, h), shifted(dst, h, 0));
+    }
+}
+}  // namespace detail
+
+/**
+ * @brief C := alpha * A * B + beta * C, cache-obliviously: the largest of m, n and k is halved until no dimension is
+ * larger than RECURSIVE_BASE_DIM, and each such piece runs the packed microkernel
+ * products of at least PARALLEL_GEMM_VOLUME are first cut into tiles of C the same way, by halving, and the tiles run
+ * on the thread pool; as with the blocked engine, the result does not depend on the number of threads
+ * @param a anything callable as a(r, c) that yields an element of A, usually a StridedView
+ * @param b anything callable as b(r, c) that yields an element of B, usually a StridedView
+ * @param c view of the output, must not alias A or B
+ */
+template <typename T, typename AView, typename BView>
+void gemm(const mult::Recursive &, size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta,
+          const StridedView<T> &c)
+{
+    if (m == 0 || n == 0 || k == 0 || alpha == T{} || m * n * k <= SMALL_GEMM_VOLUME) {
+        gemm(m, n, k, alpha, a, b, beta, c);
+        return;
+    }
+    const MicroKernel<T> kernel = select_kernel<T>();
+    const size_t threads = parallel::num_threads();
+    if (threads <= 1 || m * n * k < PARALLEL_GEMM_VOLUME) {
+        detail::recursive_gemm(0, 0, 0, m, n, k, alpha, a, b, beta, c, kernel);
+        return;
+    }
+    std::vector<detail::Tile> tiles;
+    detail::split_tiles(0, 0, m, n, threads * TILES_PER_THREAD, tiles);
+    parallel::parallel_for(tiles.size(), [&](size_t t) {
+        const detail::Tile &tile = tiles[t];
+        detail::recursive_gemm(tile.i0, tile.j0, 0, tile.m, tile.n, k, alpha, a, b, beta, c, kernel);
+    });
+}
+
+/**
+ * @brief dst := src^T for an m x n src, cache-obliviously; dst is n x m and must not overlap src
+ */
+template <typename T, typename E>
+void transpose(const mult::Recursive &, size_t m, size_t n, const StridedView<E> &src, const StridedView<T> &dst)
+{
+    detail::recursive_transpose(m, n, src, dst);
+}
+}  // namespace engine
+
+/**
+ * @brief the transpose of a, the same Mat that a.transpose() makes, computed cache-obliviously
+ */
+template <size_t R, size_t C, typename T, typename S, typename L>
+[[nodiscard]] auto transpose(const Mat<R, C, T, S, L> &a, const mult::Recursive &policy)
+{
+    if constexpr (!Mat<R, C, T, S, L>::LayoutMap::STRIDED) {
+        return a.transpose();
+    } else {
+        Mat<C, R, std::remove_const_t<T>, typename S::Result, L> ret;
+        engine::transpose(policy, R, C, a.view(), ret.view());
+        return ret;
+    }
+}
+
+/**
+ * @brief the transpose of a DynMat or MatMap as a new DynMat, computed cache-obliviously
+ */
+template <typename X, std::enable_if_t<detail::IS_DYN<X>, int> = 0>
+[[nodiscard]] auto transpose(const X &a, const mult::Recursive &policy)
+{
+    DynMat<std::remove_const_t<typename X::ElemType>> ret(a.col_count(), a.row_count());
+    engine::transpose(policy, a.row_count(), a.col_count(), a.view(), ret.view());
+    return ret;
+}
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_RECURSIVE_HPP
@@ -0,0 +1,331 @@
+#ifndef TOY_GEMM_STORAGE_HPP
+#define TOY_GEMM_STORAGE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "arena.hpp"
+
+/**
+ * Storage policies for \ref Mat, its optional 4th template parameter. A policy decides how the elements are laid out
+ * in memory, not how they are indexed: it provides a member template
+ * @code
+ * template <size_t Lines, size_t Len, typename T> struct Buffer;
+ * @endcode
+ * holding Lines lines of Len elements each (a row-major Mat has R lines of C elements), with
+ * - @c LD, the distance between the starts of consecutive lines in elements, at least Len; 0 if only known at runtime
+ * - @c ld(), that distance at runtime
+ * - @c WIDTH, how many elements of each line loops may read and write: LD when the padding belongs to the buffer
+ * - @c line(i), a reference to line i as a @c std::array<T, Len>
+ * - @c line_data(i), a pointer to the first element of line i into an array of at least WIDTH elements, for loops and
+ *   element access
+ * - @c data(), a pointer to the first element of line 0; line i starts at data() + i * ld()
+ * - @c begin() and @c end(), iterating over the lines
+ * and a member type @c Result, the policy of the matrices computed from one with this policy (the policy itself, unless
+ * it does not own its elements). Every element, padding included, is value-initialized (zero for numbers) by the
+ * default constructor. Buffers held in place (Packed, and Aligned but for its rows) keep Mat usable at compile time;
+ * Heap trades that for O(1) moves, and Ref views elements owned by someone else.
+ */
+
+namespace toy_gemm
+{
+namespace storage
+{
+/**
+ * @brief forward iterator over the lines of a Buffer
+ */
+template <typename Buffer, typename Line>
+class LineIterator
+{
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Line;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Line *;
+    using reference = const Line &;
+
+    constexpr LineIterator(const Buffer *buffer, size_t i) noexcept : buffer_(buffer), i_(i) {}
+
+    [[nodiscard]] constexpr reference operator*() const noexcept { return buffer_->line(i_); }
+    [[nodiscard]] constexpr pointer operator->() const noexcept { return &buffer_->line(i_); }
+
+    constexpr LineIterator &operator++() noexcept
+    {
+        ++i_;
+        return *this;
+    }
+
+    constexpr LineIterator operator++(int) noexcept
+    {
+        LineIterator ret = *this;
+        ++i_;
+        return ret;
+    }
+
+    [[nodiscard]] constexpr bool operator==(const LineIterator &other) const noexcept { return i_ == other.i_; }
+    [[nodiscard]] constexpr bool operator!=(const LineIterator &other) const noexcept { return i_ != other.i_; }
+
+   private:
+    const Buffer *buffer_;
+    size_t i_;
+};
+
+/**
+ * @brief lines stored back to back with no padding, in a plain 2D @c std::array; the default, and the most compact
+ */
+struct Packed final {
+    using Result = Packed;
+
+    template <size_t Lines, size_t Len, typename T>
+    struct Buffer {
+        using Line = std::array<T, Len>;
+        using Iterator = LineIterator<Buffer, Line>;
+
+        constexpr static size_t LD = Len;
+        constexpr static size_t WIDTH = Len;
+
+        [[nodiscard]] static constexpr size_t ld() noexcept { return LD; }
+
+        [[nodiscard]] constexpr Line &line(size_t i) noexcept { return lines[i]; }
+        [[nodiscard]] constexpr const Line &line(size_t i) const noexcept { return lines[i]; }
+
+        [[nodiscard]] constexpr T *line_data(size_t i) noexcept { return lines[i].data(); }
+        [[nodiscard]] constexpr const T *line_data(size_t i) const noexcept { return lines[i].data(); }
+
+        [[nodiscard]] T *data() noexcept { return lines.front().data(); }
+        [[nodiscard]] const T *data() const noexcept { return lines.front().data(); }
+
+        [[nodiscard]] constexpr Iterator begin() const noexcept { return {this, 0}; }
+        [[nodiscard]] constexpr Iterator end() const noexcept { return {this, Lines}; }
+
+        std::array<Line, Lines> lines{};
+        static_assert(sizeof(lines) == sizeof(T) * LD * Lines, "lines must be exactly LD elements apart");
+    };
+};
+
+/**
+ * @brief every line starts on an Align-byte boundary and is padded to a whole number of Align-byte blocks
+ * With Align the size of a vector register (32 for AVX2, 64 for AVX-512), a line is a whole number of vectors, so
+ * loops along lines need no scalar tail and vector loads never straddle cache lines. The padding is only ever read by
+ * loops that write the padding of their result, never by anything that reports an element, so its contents don't
+ * matter. Each line, padding included, is one array of LD elements, so that loops over whole vectors stay inside it;
+ * line(i) is a std::array of the first Len of them, placed over the line, so rows can't be used at compile time. The
+ * elements can, through line_data(i)
+ * @tparam Align alignment in bytes, a power of two; the element size must divide it
+ */
+template <size_t Align = 64>
+struct Aligned final {
+    static_assert(Align != 0 && (Align & (Align - 1)) == 0, "alignment must be a power of two");
+
+    using Result = Aligned;
+
+    template <size_t Lines, size_t Len, typename T>
+    struct Buffer {
+        static_assert(Align % sizeof(T) == 0, "the element size must divide the alignment");
+
+        constexpr static size_t LD = (Len * sizeof(T) + Align - 1) / Align * Align / sizeof(T);
+        constexpr static size_t WIDTH = LD;
+
+        [[nodiscard]] static constexpr size_t ld() noexcept { return LD; }
+
+        using Line = std::array<T, Len>;
+        using Iterator = LineIterator<Buffer, Line>;
+        static_assert(sizeof(Line) == sizeof(T) * Len, "a line must cover exactly Len elements");
+
+        [[nodiscard]] Line &line(size_t i) noexcept { return *reinterpret_cast<Line *>(line_data(i)); }
+        [[nodiscard]] const Line &line(size_t i) const noexcept
+        {
+            return *reinterpret_cast<const Line *>(line_data(i));
+        }
+
+        [[nodiscard]] constexpr T *line_data(size_t i) noexcept { return lines[i].elems.data(); }
+        [[nodiscard]] constexpr const T *line_data(size_t i) const noexcept { return lines[i].elems.data(); }
+
+        [[nodiscard]] T *data() noexcept { return line_data(0); }
+        [[nodiscard]] const T *data() const noexcept { return line_data(0); }
+
+        [[nodiscard]] constexpr Iterator begin() const noexcept { return {this, 0}; }
+        [[nodiscard]] constexpr Iterator end() const noexcept { return {this, Lines}; }
+
+        struct alignas(Align) AlignedLine {
+            std::array<T, LD> elems{};
+        };
+        static_assert(sizeof(AlignedLine) == LD * sizeof(T), "lines must be exactly LD elements apart");
+
+        std::array<AlignedLine, Lines> lines{};
+    };
+};
+
+/**
+ * @brief the buffer of another policy, on the heap: the Mat itself is a single pointer, moves are O(1) and large
+ * matrices don't need a large stack
+ * copies are deep. A moved-from Mat owns no buffer, like a moved-from std::unique_ptr: it may be assigned to or
+ * destroyed, and copies of it are zero; move assignment swaps buffers instead, so its source stays usable. Every Mat
+ * allocates, so none of it is usable at compile time, and every operation that makes a new Mat throws std::bad_alloc
+ * if allocation fails
+ * @tparam Inner the policy laying out the buffer, e.g. Heap<Aligned<64>> for aligned, padded rows on the heap
+ */
+template <typename Inner = Packed>
+struct Heap final {
+    using Result = Heap;
+
+    template <size_t Lines, size_t Len, typename T>
+    class Buffer
+    {
+       public:
+        using InnerBuffer = typename Inner::template Buffer<Lines, Len, T>;  // C++ template disambiguator
+        using Line = typename InnerBuffer::Line;
+        using Iterator = LineIterator<Buffer, Line>;
+
+        constexpr static size_t LD = InnerBuffer::LD;
+        constexpr static size_t WIDTH = InnerBuffer::WIDTH;
+
+        [[nodiscard]] static constexpr size_t ld() noexcept { return LD; }
+
+        Buffer() : buffer_(std::make_unique<InnerBuffer>()) {}
+
+        Buffer(const Buffer &other)
+            : buffer_(other.buffer_ ? std::make_unique<InnerBuffer>(*other.buffer_) : std::make_unique<InnerBuffer>())
+        {
+        }
+
+        Buffer(Buffer &&other) noexcept = default;
+
+        Buffer &operator=(const Buffer &other)
+        {
+            if (!buffer_ || !other.buffer_) {
+                *this = Buffer(other);
+            } else if (this != &other) {
+                *buffer_ = *other.buffer_;
+            }
+            return *this;
+        }
+
+        Buffer &operator=(Buffer &&other) noexcept
+        {
+            buffer_.swap(other.buffer_);
+            return *this;
+        }
+
+        ~Buffer() = default;
+
+        [[nodiscard]] Line &line(size_t i) noexcept { return buffer_->line(i); }
+        [[nodiscard]] const Line &line(size_t i) const noexcept { return buffer_->line(i); }
+
+        [[nodiscard]] T *line_data(size_t i) noexcept { return buffer_->line_data(i); }
+        [[nodiscard]] const T *line_data(size_t i) const noexcept { return buffer_->line_data(i); }
+
+        [[nodiscard]] T *data() noexcept { return buffer_->data(); }
+        [[nodiscard]] const T *data() const noexcept { return buffer_->data(); }
+
+        [[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+        [[nodiscard]] Iterator end() const noexcept { return {this, Lines}; }
+
+       private:
+        std::unique_ptr<InnerBuffer> buffer_;
+    };
+};
+
+/**
+ * @brief no buffer of its own: a view of lines that start ld elements apart in memory owned by someone else, e.g. a
+ * buffer read from a file, or a block of another matrix
+ * there is no default constructor; the buffer is made from a pointer to the first element and ld. Copies view the same
+ * elements, while assignment copies elements, so assigning to a Mat with this policy writes through it. Loops never
+ * touch the elements between the end of a line and the start of the next one, which may belong to someone else.
+ * Results computed from a view are on the Heap, as views are typically made over buffers too large for the stack
+ * @note lines are accessed as std::array<T, Len> placed over the viewed elements, so they can't be used at compile
+ * time
+ */
+struct Ref final {
+    using Result = Heap<>;
+
+    template <size_t Lines, size_t Len, typename T>
+    class Buffer
+    {
+       public:
+        using Line = std::array<T, Len>;
+        using Iterator = LineIterator<Buffer, Line>;
+        static_assert(sizeof(Line) == sizeof(T) * Len, "a line must cover exactly Len elements");
+
+        constexpr static size_t LD = 0;  ///< only known at runtime
+        constexpr static size_t WIDTH = Len;
+
+        /**
+         * @param data the first element of line 0
+         * @param ld elements from the start of a line to the start of the next one
+         * @throw std::length_error if lines would overlap
+         */
+        Buffer(T *data, size_t ld) : data_(data), ld_(ld)
+        {
+            if (ld < Len && Lines > 1) throw std::length_error("lines of a view must not overlap");
+        }
+
+        Buffer(const Buffer &) noexcept = default;
+
+        Buffer(Buffer &&) noexcept = default;
+
+        /**
+         * @throw std::bad_alloc if other overlaps this view and the arena can't grow for the copy it is read from
+         */
+        Buffer &operator=(const Buffer &other)
+        {
+            if (this == &other) return *this;
+            if (overlaps(other)) {
+                // e.g. a view assigned a view of the same buffer a line further on: read every line before writing
+                arena::Buffer<std::remove_const_t<T>> tmp(Lines * Len);
+                for (size_t i = 0; i < Lines; ++i) std::copy_n(other.line(i).begin(), Len, tmp.data() + i * Len);
+                for (size_t i = 0; i < Lines; ++i) std::copy_n(tmp.data() + i * Len, Len, line(i).begin());
+                return *this;
+            }
+            for (size_t i = 0; i < Lines; ++i) line(i) = other.line(i);
+            return *this;
+        }
+
+        Buffer &operator=(Buffer &&other) { return *this = static_cast<const Buffer &>(other); }
+
+        ~Buffer() = default;
+
+        [[nodiscard]] size_t ld() const noexcept { return ld_; }
+
+        [[nodiscard]] Line &line(size_t i) noexcept { return *reinterpret_cast<Line *>(data_ + i * ld_); }
+        [[nodiscard]] const Line &line(size_t i) const noexcept
+        {
+            return *reinterpret_cast<const Line *>(data_ + i * ld_);
+        }
+
+        [[nodiscard]] T *line_data(size_t i) noexcept { return data_ + i * ld_; }
+        [[nodiscard]] const T *line_data(size_t i) const noexcept { return data_ + i * ld_; }
+
+        [[nodiscard]] T *data() noexcept { return data_; }
+        [[nodiscard]] const T *data() const noexcept { return data_; }
+
+        [[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+        [[nodiscard]] Iterator end() const noexcept { return {this, Lines}; }
+
+       private:
+        T *data_;
+        size_t ld_;
+
+        /**
+         * @return whether the elements viewed by other and those viewed by this buffer may be the same, i.e. whether
+         * their address ranges intersect, but not at the very same elements
+         */
+        [[nodiscard]] bool overlaps(const Buffer &other) const noexcept
+        {
+            if (data_ == other.data_ && ld_ == other.ld_) return false;
+            const size_t span = (Lines - 1) * ld_ + Len;
+            const size_t other_span = (Lines - 1) * other.ld_ + Len;
+            return std::less<>{}(data_, other.data_ + other_span) && std::less<>{}(other.data_, data_ + span);
+        }
+    };
+};
+}  // namespace storage
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_STORAGE_HPP
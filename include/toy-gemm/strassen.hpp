@@ -0,0 +1,240 @@
+#ifndef TOY_GEMM_STRASSEN_HPP
+#define TOY_GEMM_STRASSEN_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "arena.hpp"
+#include "gemm.hpp"
+#include "mult.hpp"
+
+/**
+ * Fast matrix multiplication. Strassen's algorithm multiplies 2 x 2 blocks with 7 products of half the size instead
+ * of 8, for O(n^2.81) work; applied recursively it beats the O(n^3) engine on large products, at the price of a
+ * different rounding (the error bound grows with the number of levels, but stays normwise-stable). It is opt-in, as a
+ * multiplication policy (see mult.hpp) passed to \ref multiply:
+ * @code
+ * auto c = multiply(a, b, mult::Winograd{});      // a and b: large Mats, DynMats or MatMaps
+ * auto d = multiply(a, b, mult::Strassen{1024});  // classic Strassen, recursing down to 1024 x 1024 products
+ * @endcode
+ * Recursion stops at the crossover, where the halves go to the blocked engine (and its thread pool); operands whose
+ * dimensions don't halve evenly down to there are zero-padded once, up front, from the thread-local arena
+ */
+
+namespace toy_gemm
+{
+namespace mult
+{
+constexpr size_t DEFAULT_CROSSOVER = 512;  ///< default size at and below which the fast policies stop recursing
+
+/**
+ * @brief Strassen (1969): 7 half-size products and 18 additions per level
+ */
+struct Strassen final {
+    size_t crossover = DEFAULT_CROSSOVER;  ///< recurse while the smallest of m, n and k is larger than this
+};
+
+/**
+ * @brief the Winograd variant of Strassen's algorithm: 7 half-size products and 15 additions per level
+ */
+struct Winograd final {
+    size_t crossover = DEFAULT_CROSSOVER;  ///< recurse while the smallest of m, n and k is larger than this
+};
+
+namespace detail
+{
+template <typename P>
+constexpr bool IS_FAST = std::is_same_v<P, Strassen> || std::is_same_v<P, Winograd>;
+
+template <>
+constexpr bool IS_POLICY<Strassen> = true;
+
+template <>
+constexpr bool IS_POLICY<Winograd> = true;
+}  // namespace detail
+}  // namespace mult
+
+namespace engine
+{
+namespace detail
+{
+template <typename T>
+[[nodiscard]] StridedView<T> quadrant(const StridedView<T> &v, size_t r0, size_t c0) noexcept
+{
+    return {&v(r0, c0), v.row_stride, v.col_stride};
+}
+
+/**
+ * @brief out := x + sign * y over m x n elements
+ */
+template <typename T, typename XView, typename YView>
+void combine(size_t m, size_t n, const XView &x, T sign, const YView &y, const StridedView<T> &out)
+{
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) out(i, j) = static_cast<T>(x(i, j)) + sign * static_cast<T>(y(i, j));
+    }
+}
+
+/**
+ * @brief c := a * b, halving all three dimensions while the smallest of them is above the crossover; the caller pads
+ * them so they stay even down to there
+ */
+template <typename P, typename T, typename AView, typename BView>
+void fast_product(const P &policy, size_t m, size_t n, size_t k, const AView &a, const BView &b,
+                  const StridedView<T> &c)
+{
+    if (std::min({m, n, k}) <= policy.crossover || m % 2 != 0 || n % 2 != 0 || k % 2 != 0) {
+        gemm(m, n, k, T{1}, a, b, T{}, c);
+        return;
+    }
+    const size_t hm = m / 2;
+    const size_t hn = n / 2;
+    const size_t hk = k / 2;
+    const auto a11 = quadrant(a, 0, 0), a12 = quadrant(a, 0, hk), a21 = quadrant(a, hm, 0), a22 = quadrant(a, hm, hk);
+    const auto b11 = quadrant(b, 0, 0), b12 = quadrant(b, 0, hn), b21 = quadrant(b, hk, 0), b22 = quadrant(b, hk, hn);
+    const auto c11 = quadrant(c, 0, 0), c12 = quadrant(c, 0, hn), c21 = quadrant(c, hm, 0), c22 = quadrant(c, hm, hn);
+
+    // scratch for a sum of A blocks, a sum of B blocks, a running sum and a product; freed before the next sibling
+    arena::Buffer<T> s_buf(hm * hk);
+    arena::Buffer<T> t_buf(hk * hn);
+    arena::Buffer<T> u_buf(hm * hn);
+    arena::Buffer<T> p_buf(hm * hn);
+    const StridedView<T> s{s_buf.data(), static_cast<std::ptrdiff_t>(hk), 1};
+    const StridedView<T> t{t_buf.data(), static_cast<std::ptrdiff_t>(hn), 1};
+    const StridedView<T> u{u_buf.data(), static_cast<std::ptrdiff_t>(hn), 1};
+    const StridedView<T> p{p_buf.data(), static_cast<std::ptrdiff_t>(hn), 1};
+    const auto product = [&](const auto &x, const auto &y) { fast_product(policy, hm, hn, hk, x, y, p); };
+    const auto add = [&](const StridedView<T> &dst, T sign) { axpby(hm, hn, sign, p, T{1}, dst); };
+    const auto set = [&](const StridedView<T> &dst, T sign) { axpby(hm, hn, sign, p, T{}, dst); };
+
+    if constexpr (std::is_same_v<P, mult::Strassen>) {
+        // M1 = (A11 + A22)(B11 + B22), M2 = (A21 + A22) B11, M3 = A11 (B12 - B22), M4 = A22 (B21 - B11),
+        // M5 = (A11 + A12) B22, M6 = (A21 - A11)(B11 + B12), M7 = (A12 - A22)(B21 + B22);
+        // C11 = M1 + M4 - M5 + M7, C12 = M3 + M5, C21 = M2 + M4, C22 = M1 - M2 + M3 + M6
+        combine(hm, hk, a11, T{1}, a22, s);
+        combine(hk, hn, b11, T{1}, b22, t);
+        product(s, t);
+        set(c11, T{1});
+        set(c22, T{1});
+        combine(hm, hk, a21, T{1}, a22, s);
+        product(s, b11);
+        set(c21, T{1});
+        add(c22, T{-1});
+        combine(hk, hn, b12, T{-1}, b22, t);
+        product(a11, t);
+        set(c12, T{1});
+        add(c22, T{1});
+        combine(hk, hn, b21, T{-1}, b11, t);
+        product(a22, t);
+        add(c11, T{1});
+        add(c21, T{1});
+        combine(hm, hk, a11, T{1}, a12, s);
+        product(s, b22);
+        add(c11, T{-1});
+        add(c12, T{1});
+        combine(hm, hk, a21, T{-1}, a11, s);
+        combine(hk, hn, b11, T{1}, b12, t);
+        product(s, t);
+        add(c22, T{1});
+        combine(hm, hk, a12, T{-1}, a22, s);
+        combine(hk, hn, b21, T{1}, b22, t);
+        product(s, t);
+        add(c11, T{1});
+    } else {
+        // S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2,
+        // T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21;
+        // P1 = A11 B11, P2 = A12 B21, P3 = S4 B22, P4 = A22 T4, P5 = S1 T1, P6 = S2 T2, P7 = S3 T3;
+        // U2 = P1 + P6, U3 = U2 + P7: C11 = P1 + P2, C12 = U2 + P5 + P3, C21 = U3 - P4, C22 = U3 + P5
+        product(a11, b11);
+        set(c11, T{1});
+        set(u, T{1});
+        product(a12, b21);
+        add(c11, T{1});
+        combine(hm, hk, a21, T{1}, a22, s);
+        combine(hk, hn, b12, T{-1}, b11, t);
+        product(s, t);
+        set(c12, T{1});
+        set(c22, T{1});
+        combine(hm, hk, s, T{-1}, a11, s);
+        combine(hk, hn, b22, T{-1}, t, t);
+        product(s, t);
+        add(u, T{1});
+        axpby(hm, hn, T{1}, u, T{1}, c12);
+        axpby(hm, hn, T{1}, u, T{1}, c22);
+        combine(hm, hk, a12, T{-1}, s, s);
+        product(s, b22);
+        add(c12, T{1});
+        combine(hk, hn, t, T{-1}, b21, t);
+        product(a22, t);
+        set(c21, T{-1});
+        combine(hm, hk, a11, T{-1}, a21, s);
+        combine(hk, hn, b22, T{-1}, b12, t);
+        product(s, t);
+        add(u, T{1});
+        add(c22, T{1});
+        axpby(hm, hn, T{1}, u, T{1}, c21);
+    }
+}
+
+/**
+ * @brief copy the m x n x into the top-left corner of a rows x cols buffer, zeroing the rest
+ */
+template <typename T, typename XView>
+void pad(size_t m, size_t n, const XView &x, size_t rows, size_t cols, const StridedView<T> &out)
+{
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) out(i, j) = i < m && j < n ? static_cast<T>(x(i, j)) : T{};
+    }
+}
+}  // namespace detail
+
+/**
+ * @brief C := alpha * A * B + beta * C with Strassen's algorithm or its Winograd variant
+ * each level halves m, n and k while the smallest of them is above policy.crossover; the products left at that point
+ * run on the blocked engine. Unless m, n and k halve evenly that many times, A and B are copied once into buffers
+ * padded with zeros; the product goes through a buffer too when it isn't a plain C := A * B
+ * @param a anything callable as a(r, c) that yields an element of A, usually a StridedView
+ * @param b anything callable as b(r, c) that yields an element of B, usually a StridedView
+ * @param c view of the output, must not alias A or B
+ */
+template <typename P, typename T, typename AView, typename BView, std::enable_if_t<mult::detail::IS_FAST<P>, int> = 0>
+void gemm(const P &policy, size_t m, size_t n, size_t k, T alpha, const AView &a, const BView &b, T beta,
+          const StridedView<T> &c)
+{
+    const size_t crossover = std::max<size_t>(policy.crossover, 1);
+    size_t levels = 0;
+    for (size_t d = std::min({m, n, k}); d > crossover; d = (d + 1) / 2) ++levels;
+    if (levels == 0 || alpha == T{}) {
+        gemm(m, n, k, alpha, a, b, beta, c);
+        return;
+    }
+    const P inner{crossover};
+    const size_t multiple = size_t{1} << levels;
+    const size_t pm = round_up(m, multiple);
+    const size_t pn = round_up(n, multiple);
+    const size_t pk = round_up(k, multiple);
+    const bool direct = alpha == T{1} && beta == T{} && pm == m && pn == n;
+    arena::Buffer<T> c_buf(direct ? 0 : pm * pn);
+    const StridedView<T> pc = direct ? c : StridedView<T>{c_buf.data(), static_cast<std::ptrdiff_t>(pn), 1};
+
+    if constexpr (std::is_same_v<AView, StridedView<const T>> && std::is_same_v<BView, StridedView<const T>>) {
+        if (pm == m && pn == n && pk == k) {
+            detail::fast_product(inner, pm, pn, pk, a, b, pc);
+            if (!direct) axpby(m, n, alpha, pc, beta, c);
+            return;
+        }
+    }
+    arena::Buffer<T> a_buf(pm * pk);
+    arena::Buffer<T> b_buf(pk * pn);
+    const StridedView<T> pa{a_buf.data(), static_cast<std::ptrdiff_t>(pk), 1};
+    const StridedView<T> pb{b_buf.data(), static_cast<std::ptrdiff_t>(pn), 1};
+    detail::pad(m, k, a, pm, pk, pa);
+    detail::pad(k, n, b, pk, pn, pb);
+    detail::fast_product(inner, pm, pn, pk, pa, pb, pc);
+    if (!direct) axpby(m, n, alpha, pc, beta, c);
+}
+}  // namespace engine
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_STRASSEN_HPP
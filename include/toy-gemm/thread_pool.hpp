@@ -0,0 +1,327 @@
+#ifndef TOY_GEMM_THREAD_POOL_HPP
+#define TOY_GEMM_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace toy_gemm
+{
+namespace parallel
+{
+/**
+ * @brief the tasks [begin, end) a thread still has to run, as a lock-free deque of task indices
+ * the owning thread pops single tasks off the front, idle threads steal the back half; both are one compare-exchange
+ * on a single word holding both ends. A range only ever shrinks, and is only refilled by its owner once it is empty,
+ * so a stale read can't compare equal to a different range (no ABA)
+ */
+class alignas(64) TaskRange  // one cache line each, the ranges of different threads are hammered concurrently
+{
+   public:
+    using Index = std::uint32_t;
+
+    /**
+     * @brief start over with [begin, end); only the owner may call this, and only while the range is empty
+     */
+    void reset(Index begin, Index end) noexcept { range_.store(pack(begin, end), std::memory_order_release); }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        const auto r = range_.load(std::memory_order_relaxed);
+        return end_of(r) - begin_of(r);
+    }
+
+    /**
+     * @brief take the task at the front; called by the owner
+     * @return false if the range was empty
+     */
+    bool pop(Index &task) noexcept
+    {
+        auto r = range_.load(std::memory_order_acquire);
+        while (begin_of(r) < end_of(r)) {
+            if (range_.compare_exchange_weak(r, pack(begin_of(r) + 1, end_of(r)), std::memory_order_acq_rel)) {
+                task = begin_of(r);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief take the back half (rounded up) of this range; called by any thread but the owner
+     * @return false if the range was empty
+     */
+    bool steal(Index &begin, Index &end) noexcept
+    {
+        auto r = range_.load(std::memory_order_acquire);
+        while (begin_of(r) < end_of(r)) {
+            const Index split = end_of(r) - (end_of(r) - begin_of(r) + 1) / 2;
+            if (range_.compare_exchange_weak(r, pack(begin_of(r), split), std::memory_order_acq_rel)) {
+                begin = split;
+                end = end_of(r);
+                return true;
+            }
+        }
+        return false;
+    }
+
+   private:
+    std::atomic<std::uint64_t> range_{0};
+
+    [[nodiscard]] static constexpr std::uint64_t pack(Index begin, Index end) noexcept
+    {
+        return static_cast<std::uint64_t>(begin) << 32U | end;
+    }
+    [[nodiscard]] static constexpr Index begin_of(std::uint64_t r) noexcept { return static_cast<Index>(r >> 32U); }
+    [[nodiscard]] static constexpr Index end_of(std::uint64_t r) noexcept { return static_cast<Index>(r); }
+};
+
+namespace detail
+{
+/**
+ * @return whether the calling thread is working on a job of a ThreadPool: set for its workers, and for the caller of
+ * ThreadPool::run while it runs tasks
+ */
+inline bool &in_pool_job() noexcept
+{
+    thread_local bool in_job = false;
+    return in_job;
+}
+}  // namespace detail
+
+/**
+ * @brief fixed set of worker threads that run the tasks of one job at a time
+ * the thread calling \ref run works on the job too, so a pool of size n spawns n - 1 threads; they sleep between jobs
+ * and live as long as the pool does. Tasks are scheduled by work stealing: each thread starts on an even, contiguous
+ * share of them (see \ref TaskRange) and, once done with its own, steals half of what is left of another thread's, so
+ * a thread that got descheduled or drew the expensive tasks holds up the job for at most one task
+ */
+class ThreadPool
+{
+   public:
+    /**
+     * @param threads number of threads working on each job, including the caller of \ref run; at least 1
+     */
+    explicit ThreadPool(size_t threads) : ranges_(std::make_unique<TaskRange[]>(std::max<size_t>(threads, 1)))
+    {
+        const size_t workers = std::max<size_t>(threads, 1) - 1;
+        workers_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) workers_.emplace_back([this, i] { work(i + 1); });
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto &w : workers_) w.join();
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return workers_.size() + 1; }
+
+    /**
+     * @brief call task(i) for every i in [0, tasks), spread over the threads of the pool, and wait for all of them
+     * thread t starts on tasks [tasks * t / size(), tasks * (t + 1) / size()), in increasing order, so neighbouring
+     * tasks mostly run on the same thread
+     * @throw rethrows the first exception thrown by a task, after every task has finished
+     * @note not reentrant: one job at a time, and a task must not call run on the pool running it
+     */
+    void run(size_t tasks, const std::function<void(size_t)> &task)
+    {
+        if (tasks > std::numeric_limits<TaskRange::Index>::max()) throw std::length_error("too many tasks");
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &task;
+            for (size_t t = 0; t < size(); ++t) {
+                ranges_[t].reset(static_cast<TaskRange::Index>(tasks * t / size()),
+                                 static_cast<TaskRange::Index>(tasks * (t + 1) / size()));
+            }
+            running_ = workers_.size();
+            error_ = nullptr;
+            ++generation_;
+        }
+        wake_.notify_all();
+        const bool outer = std::exchange(detail::in_pool_job(), true);
+        drain(0);
+        detail::in_pool_job() = outer;
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return running_ == 0; });
+        job_ = nullptr;
+        if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+   private:
+    std::vector<std::thread> workers_;
+    std::unique_ptr<TaskRange[]> ranges_;  ///< one per thread; the caller of run is thread 0
+    std::mutex mutex_;
+    std::condition_variable wake_;  ///< a new job is up, or the pool is shutting down
+    std::condition_variable done_;  ///< every worker is done with the current job
+
+    // the current job; written under mutex_ before workers are woken up
+    const std::function<void(size_t)> *job_ = nullptr;
+    size_t running_ = 0;     ///< workers that have not finished with the current job yet
+    size_t generation_ = 0;  ///< bumped once per job
+    std::exception_ptr error_;
+    bool stop_ = false;
+
+    /**
+     * @brief run the tasks of thread self, then steal from the others until every range is empty
+     */
+    void drain(size_t self) noexcept
+    {
+        TaskRange &own = ranges_[self];
+        for (;;) {
+            TaskRange::Index i;
+            while (own.pop(i)) {
+                try {
+                    (*job_)(i);
+                } catch (...) {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    if (!error_) error_ = std::current_exception();
+                }
+            }
+            if (!steal(self)) return;
+        }
+    }
+
+    /**
+     * @brief refill the range of thread self from the fullest range of the others
+     * @return false if there is nothing left to steal; tasks that have been popped may still be running
+     */
+    bool steal(size_t self) noexcept
+    {
+        for (;;) {
+            size_t victim = self;
+            size_t most = 0;
+            for (size_t t = 0; t < size(); ++t) {
+                const size_t left = t == self ? 0 : ranges_[t].size();
+                if (left > most) {
+                    most = left;
+                    victim = t;
+                }
+            }
+            if (victim == self) return false;
+            TaskRange::Index begin;
+            TaskRange::Index end;
+            if (ranges_[victim].steal(begin, end)) {
+                ranges_[self].reset(begin, end);
+                return true;
+            }
+            // lost the race for the last of it, look again
+        }
+    }
+
+    void work(size_t self)
+    {
+        detail::in_pool_job() = true;
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            lock.unlock();
+            drain(self);
+            lock.lock();
+            if (--running_ == 0) done_.notify_one();
+        }
+    }
+};
+
+namespace detail
+{
+/**
+ * @return TOY_GEMM_NUM_THREADS from the environment if set to a positive number, otherwise the number of hardware
+ * threads
+ */
+inline size_t default_thread_count() noexcept
+{
+    if (const char *env = std::getenv("TOY_GEMM_NUM_THREADS")) {
+        const long n = std::strtol(env, nullptr, 10);
+        if (n > 0) return static_cast<size_t>(n);
+    }
+    return std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+}
+
+/**
+ * @brief the process-wide pool behind \ref parallel_for; created on first use, recreated when the thread count changes
+ */
+struct PoolState final {
+    std::mutex mutex;  ///< held for the whole of a job, so jobs from different threads don't interleave
+    std::atomic<size_t> threads{default_thread_count()};
+    std::unique_ptr<ThreadPool> pool;
+};
+
+inline PoolState &pool_state() noexcept
+{
+    static PoolState state;
+    return state;
+}
+}  // namespace detail
+
+/**
+ * @return how many threads a parallel product may use
+ */
+[[nodiscard]] inline size_t num_threads() noexcept
+{
+    return detail::pool_state().threads.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief set how many threads parallel products may use; 1 makes every product serial
+ * @param n number of threads, including the calling one; 0 goes back to the default (see TOY_GEMM_NUM_THREADS)
+ * @note waits for a running job to finish; the threads themselves are only (re)started by the next job. Called by a
+ * task of a job, it can't wait for that job, and leaves resizing the pool to the next one
+ */
+inline void set_num_threads(size_t n)
+{
+    auto &state = detail::pool_state();
+    if (detail::in_pool_job()) {
+        state.threads = n == 0 ? detail::default_thread_count() : n;
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    state.threads = n == 0 ? detail::default_thread_count() : n;
+    if (state.pool && state.pool->size() != state.threads) state.pool.reset();
+}
+
+/**
+ * @brief call task(i) for every i in [0, tasks) on the shared pool, and wait for all of them
+ * falls back to a plain loop on the calling thread when there is a single task, a single thread, or when the pool is
+ * already busy (another thread's job, or a task of this job calling parallel_for again)
+ */
+template <typename F>
+void parallel_for(size_t tasks, F &&task)
+{
+    auto &state = detail::pool_state();
+    std::unique_lock<std::mutex> lock(state.mutex, std::defer_lock);
+    // a task of a job must not try_lock the mutex: the thread that started the job holds it already
+    if (tasks <= 1 || num_threads() <= 1 || detail::in_pool_job() || !lock.try_lock()) {
+        for (size_t i = 0; i < tasks; ++i) task(i);
+        return;
+    }
+    if (state.pool && state.pool->size() != state.threads) state.pool.reset();  // resized from within a job
+    if (!state.pool) state.pool = std::make_unique<ThreadPool>(state.threads);
+    state.pool->run(tasks, std::function<void(size_t)>(std::ref(task)));
+}
+}  // namespace parallel
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_THREAD_POOL_HPP
@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <thread>
+#include <toy-gemm/arena.hpp>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/matrix.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+namespace
+{
+bool is_aligned(const void *p, size_t align) { return reinterpret_cast<std::uintptr_t>(p) % align == 0; }
+}  // namespace
+
+TEST(toy_gemm_arena, buffers)
+{
+    // a thread of its own, so the arena starts out empty
+    std::thread([] {
+        ASSERT_EQ(arena::stats().bytes_reserved, 0);
+        {
+            arena::Buffer<float> a(10);
+            arena::Buffer<double> b(1000);
+            ASSERT_TRUE(is_aligned(a.data(), 64));
+            ASSERT_TRUE(is_aligned(b.data(), 64));
+            ASSERT_EQ(reinterpret_cast<const char *>(b.data()) - reinterpret_cast<const char *>(a.data()), 64);
+            ASSERT_EQ(arena::stats().requests, 2);
+            ASSERT_EQ(arena::stats().heap_allocations, 1);
+            ASSERT_EQ(arena::stats().bytes_in_use, 64 + 8000);
+            {
+                // larger than what is left: the arena grows
+                arena::Buffer<char> c(arena::Arena::MIN_BLOCK);
+                ASSERT_EQ(arena::stats().heap_allocations, 2);
+            }
+            ASSERT_EQ(arena::stats().bytes_in_use, 64 + 8000);
+        }
+        // nothing in use any more: the two blocks became one, large enough for all of the above
+        const auto stats = arena::stats();
+        ASSERT_EQ(stats.bytes_in_use, 0);
+        ASSERT_EQ(stats.heap_allocations, 3);
+        ASSERT_EQ(stats.bytes_reserved, 3 * arena::Arena::MIN_BLOCK);
+        ASSERT_EQ(stats.peak_bytes, 2 * arena::Arena::MIN_BLOCK);  // the rest of the first block went unused
+        {
+            arena::Buffer<float> a(10);
+            arena::Buffer<double> b(1000);
+            arena::Buffer<char> c(arena::Arena::MIN_BLOCK);
+        }
+        ASSERT_EQ(arena::stats().heap_allocations, 3);
+
+        arena::shrink();
+        ASSERT_EQ(arena::stats().bytes_reserved, 0);
+    }).join();
+}
+
+TEST(toy_gemm_arena, reuse_across_products)
+{
+    parallel::set_num_threads(1);
+    const auto a = make_mat<67, 45>(1);
+    const auto b = make_mat<45, 80>(2);
+    const auto expected = DynMat<double>(a) * DynMat<double>(b);
+    ASSERT_EQ(DynMat<double>(a * b), expected);
+
+    // the packing buffers of the second product come out of the memory of the first one
+    const auto before = arena::stats();
+    ASSERT_GT(before.bytes_reserved, 0);
+    ASSERT_EQ(DynMat<double>(a * b), expected);
+    const auto after = arena::stats();
+    ASSERT_EQ(after.heap_allocations, before.heap_allocations);
+    ASSERT_EQ(after.requests, before.requests + 2);
+    ASSERT_EQ(after.bytes_in_use, 0);
+
+    // on the thread pool too, each worker with an arena of its own
+    parallel::set_num_threads(4);
+    const auto c = make_mat<128, 128>(3);
+    const auto cc = DynMat<double>(c) * DynMat<double>(c);
+    ASSERT_EQ(DynMat<double>(c * c), cc);
+    const auto total = arena::total_stats();
+    ASSERT_GT(total.requests, after.requests);
+    ASSERT_EQ(total.bytes_in_use, 0);
+    ASSERT_GE(total.bytes_reserved, arena::stats().bytes_reserved);
+    parallel::set_num_threads(0);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <toy-gemm/chain.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+TEST(toy_gemm_chain, plan)
+{
+    // (A * B) * C is 10 * 100 * 5 + 10 * 5 * 50 = 7'500; A * (B * C) is 100 * 5 * 50 + 10 * 100 * 50 = 75'000
+    using ABC = ChainOrder<Mat<10, 100>, Mat<100, 5>, Mat<5, 50>>;
+    static_assert(ABC::OPTIMAL_COST == 7'500);
+    static_assert(ABC::LEFT_TO_RIGHT_COST == 7'500);
+    static_assert(ABC::split(0, 2) == 1);
+
+    // CLRS 15.2: ((A1 (A2 A3)) ((A4 A5) A6)) at 15'125
+    using CLRS = ChainOrder<Mat<30, 35>, Mat<35, 15>, Mat<15, 5>, Mat<5, 10>, Mat<10, 20>, Mat<20, 25>>;
+    static_assert(CLRS::OPTIMAL_COST == 15'125);
+    static_assert(CLRS::split(0, 5) == 2);
+    static_assert(CLRS::split(0, 2) == 0);
+    static_assert(CLRS::split(3, 5) == 4);
+    static_assert(CLRS::OPTIMAL_COST < CLRS::LEFT_TO_RIGHT_COST);
+
+    using Single = ChainOrder<Mat<3, 4>>;
+    static_assert(Single::OPTIMAL_COST == 0);
+}
+
+TEST(toy_gemm_chain, constexpr_chain)
+{
+    constexpr Mat<2, 3> a{1, 2, 3, 4, 5, 6};
+    constexpr Mat<3, 1> b{1, -1, 2};
+    constexpr Mat<1, 3> c{3, 0, -2};
+    constexpr Mat<3, 2> d{1, 0, 0, 1, 1, 1};
+    static_assert(chain(a, b, c, d) == a * b * c * d);
+    static_assert(chain(a) == a);
+}
+
+TEST(toy_gemm_chain, uneven_shapes)
+{
+    // left to right builds a 200 x 200 intermediate; the planned order never does
+    const auto a = make_mat<200, 8>(1);
+    const auto b = make_mat<8, 200>(2);
+    const auto c = make_mat<200, 6>(3);
+    const auto d = make_mat<6, 40>(4);
+    const auto e = make_mat<40, 3, int>(5);
+    using Order =
+        ChainOrder<Mat<200, 8, double>, Mat<8, 200, double>, Mat<200, 6, double>, Mat<6, 40, double>, Mat<40, 3>>;
+    static_assert(Order::OPTIMAL_COST * 10 < Order::LEFT_TO_RIGHT_COST);
+
+    const auto product = chain(a, b, c, d, e);
+    static_assert(std::is_same_v<std::remove_cv_t<decltype(product)>, Mat<200, 3, double>>);
+    ASSERT_EQ(product, a * b * c * d * e);  // small integers, so every order is exact
+}
@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <gtest/gtest.h>
+#include <numeric>
 #include <toy-gemm/matrix.hpp>
+#include "test-util.hpp"
 
 using namespace toy_gemm;
+using namespace toy_gemm::test;
 using M22 = Mat<2, 2>;
 using M23 = Mat<2, 3>;
 using M32 = Mat<3, 2>;
@@ -19,6 +23,8 @@ TEST(toy_gemm, ctor)
     constexpr decltype(x) y(0, 0, 0, 0, 0, 0, 0, 0, 0);
     static_assert(x == zeros);
     static_assert(y == zeros);
+    constexpr M22 sevens(7);  // uniform init sets every element
+    static_assert(sevens == M22{7, 7, 7, 7});
     constexpr M32 z{1, 2, 3, 4, 5, 6};
     M32 z_list_ctor{{1, 2}, {3, 4}, {5, 6}};  // sadly unable to constexpr this
     M32 z_copy_ctor(z);
@@ -40,6 +46,21 @@ TEST(toy_gemm_accessor, get_and_bracket)
     ASSERT_EQ(I3.at(0, 0), 1);
 }
 
+TEST(toy_gemm_accessor, bounds_checks)
+{
+    M23 m{1, 2, 3, 4, 5, 6};
+    static_assert(noexcept(m[0]), "operator[] does not check, so it can't throw");
+    ASSERT_THROW(static_cast<void>(m.at(2)), std::out_of_range);  // at() always checks
+    // a row is the std::array line itself, whose operator[] this library can't check; at(r, c) checks the column
+    static_assert(std::is_same_v<decltype(m[0]), M23::RowType &>);
+    ASSERT_THROW(static_cast<void>(m.at(0, 3)), std::out_of_range);
+    ASSERT_THROW(static_cast<void>(m.at(0).at(3)), std::out_of_range);
+#if TOY_GEMM_BOUNDS_CHECK
+    ASSERT_DEATH(static_cast<void>(m[2]), "row index out of range");
+    ASSERT_DEATH(static_cast<void>(m.col(0)[2]), "row index out of range");
+#endif
+}
+
 TEST(toy_gemm_accessor, rows)
 {
     const M23 m23({1, 2, 3}, {4, 5, 6});
@@ -75,6 +96,45 @@ TEST(toy_gemm_accessor, col)
     y.col_view<1>() = std::make_tuple(0, 0);
     constexpr M22 yy{1, 0, 3, 0};
     ASSERT_EQ(y, yy);
+
+    constexpr M23 z{1, 2, 3, 4, 5, 6};  // columns of a non-square matrix have R elements
+    constexpr auto zcol = z.get_col<2>();
+    ASSERT_EQ(zcol, (M23::ColType{3, 6}));
+}
+
+TEST(toy_gemm_accessor, col_iterator)
+{
+    auto m = make_mat<5, 4, int>(1);
+    const auto &cm = m;
+    for (size_t c = 0; c < 4; ++c) {
+        size_t r = 0;
+        for (int e : cm.col(c)) ASSERT_EQ(e, m.at(r++, c));  // shall be compatible with range for
+        ASSERT_EQ(r, 5);
+    }
+    ASSERT_THROW(static_cast<void>(m.col(4)), std::out_of_range);
+    ASSERT_THROW(static_cast<void>(m.col(0).at(5)), std::out_of_range);
+
+    // random access, for the standard algorithms
+    const auto col = cm.col(2);
+    static_assert(std::is_same_v<std::iterator_traits<decltype(col.begin())>::iterator_category,
+                                 std::random_access_iterator_tag>);
+    ASSERT_EQ(col.end() - col.begin(), 5);
+    ASSERT_EQ(col.begin()[3], m.at(3, 2));
+    ASSERT_EQ(*(col.end() - 1), m.at(4, 2));
+    ASSERT_EQ(*(2 + col.begin()), m.at(2, 2));
+    const auto copy = m.get_col<2>();
+    ASSERT_EQ(std::accumulate(col.begin(), col.end(), 0), std::accumulate(copy.begin(), copy.end(), 0));
+    ASSERT_EQ(*std::max_element(col.begin(), col.end()), *std::max_element(copy.begin(), copy.end()));
+
+    std::sort(m.col(1).begin(), m.col(1).end());
+    ASSERT_TRUE(std::is_sorted(cm.col(1).begin(), cm.col(1).end()));
+    std::fill(m.col(0).begin(), m.col(0).end(), 9);
+    ASSERT_EQ(m.get_col<0>(), (Vec<int, 5>{9, 9, 9, 9, 9}));
+
+    // a column of a column-major matrix is contiguous
+    Mat<5, 4, int, storage::Packed, layout::ColMajor> col_major(m);
+    ASSERT_EQ(col_major.col(3).stride(), 1);
+    ASSERT_TRUE(std::equal(col_major.col(3).begin(), col_major.col(3).end(), m.col(3).begin()));
 }
 
 TEST(toy_gemm_ops, comparison)
@@ -94,6 +154,41 @@ TEST(toy_gemm_ops, transpose)
     static_assert(m32 == m23_t, "value must match");
 }
 
+TEST(toy_gemm_ops, transpose_in_place)
+{
+    constexpr M33 m33 = [] {
+        M33 m{1, 2, 3, 4, 5, 6, 7, 8, 9};
+        m.transpose_in_place();
+        return m;
+    }();
+    static_assert(m33 == M33{1, 4, 7, 2, 5, 8, 3, 6, 9}, "value must match");
+
+    // blocked swaps at runtime, with a ragged edge
+    const auto a = make_mat<45, 45, int>(1);
+    const auto a_t = a.transpose();
+    auto b = a;
+    ASSERT_EQ(b.transpose_in_place(), a_t);
+    Mat<45, 45, int, storage::Packed, layout::ColMajor> c(a);
+    ASSERT_EQ(c.transpose_in_place(), decltype(c)(a_t));
+    Mat<45, 45, int, storage::Packed, layout::Tiled<8>> d(a);
+    ASSERT_EQ(d.transpose_in_place(), decltype(d)(a_t));
+}
+
+TEST(toy_gemm_ops, transpose_view)
+{
+    const M23 m23{1, 2, 3, 4, 5, 6};
+    const auto m23_t = m23.transpose_view();
+    ASSERT_EQ(m23_t.row_count(), 3);
+    ASSERT_EQ(m23_t.col_count(), 2);
+    ASSERT_EQ(m23_t.at(2, 1), 6);
+    ASSERT_EQ(&m23_t.base(), &m23);
+
+    const M32 m32 = m23.transpose();
+    ASSERT_EQ(m23 * m23_t, m23 * m32);
+    ASSERT_EQ(m23_t * m23, m32 * m23);
+    ASSERT_EQ(m32.transpose_view() * m23_t, m23 * m32);
+}
+
 TEST(toy_gemm_ops, multiplication)
 {
     constexpr M22 x{1, 2, 3, 4};
@@ -109,6 +204,30 @@ TEST(toy_gemm_ops, multiplication)
     const M34 m34 = m43.transpose();
     const M44 m44({14, 32, 50, 68}, {32, 77, 122, 167}, {50, 122, 194, 266}, {68, 167, 266, 365});
     ASSERT_EQ(m43 * m34, m44);
+
+    // large products allocate packing buffers and may run on the thread pool, so std::bad_alloc gets through
+    static_assert(!noexcept(m43 * m34));
+    static_assert(!noexcept(m43 * m43.transpose_view()));
+    static_assert(!noexcept(std::declval<M44 &>() *= m44));
+}
+
+TEST(toy_gemm_ops, constexpr_large)
+{
+    // evaluated by the compiler; these used to exhaust it well before 64 x 64
+    constexpr auto a = make_mat<64, 64, int>(1);
+    constexpr auto b = make_mat<64, 64, int>(2);
+    constexpr auto ab = a * b;
+    static_assert(ab.transpose() == b.transpose() * a.transpose());
+    constexpr auto c = make_mat<96, 80, int>(3);
+    constexpr Mat<80, 96> c_t = c.transpose();
+    static_assert(c_t.get<79, 95>() == c.get<95, 79>());
+    static_assert(c_t.get_col<95>()[79] == c.get<95, 79>());
+    static_assert(Mat<128>::identity() * make_mat<128, 16, int>(4) == make_mat<128, 16, int>(4));
+    static_assert((make_mat<128, 16, int>(4) * make_mat<16, 128, int>(5)).transpose().get<127, 0>() == 22);
+
+    // the same products at runtime go through the gemm engine
+    const auto a_rt = a;
+    ASSERT_EQ(a_rt * b, ab);
 }
 
 TEST(toy_gemm_ops, special_functions)
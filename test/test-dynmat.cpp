@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <utility>
+
+using namespace toy_gemm;
+
+TEST(toy_gemm_dynmat, ctor)
+{
+    const DynMat<int> empty;
+    ASSERT_EQ(empty.row_count(), 0);
+    ASSERT_EQ(empty.col_count(), 0);
+
+    const DynMat<int> zeros(2, 3);
+    const DynMat<int> list_ctor{{0, 0, 0}, {0, 0, 0}};
+    ASSERT_EQ(zeros, list_ctor);
+    ASSERT_EQ(zeros, DynMat<int>::zeros(2, 3));
+    ASSERT_EQ(DynMat<int>(2, 2, 7), (DynMat<int>{{7, 7}, {7, 7}}));
+    ASSERT_THROW((DynMat<int>{{1, 2}, {3}}), std::length_error);
+
+    DynMat<int> copy(list_ctor);
+    ASSERT_EQ(copy, list_ctor);
+    copy.at(1, 2) = 1;
+    ASSERT_NE(copy, list_ctor);
+    const DynMat<int> moved(std::move(copy));
+    ASSERT_EQ(moved.at(1, 2), 1);
+}
+
+TEST(toy_gemm_dynmat, accessor)
+{
+    DynMat<float> m{{1, 2, 3}, {4, 5, 6}};
+    ASSERT_EQ(m.row_count(), 2);
+    ASSERT_EQ(m.col_count(), 3);
+    ASSERT_EQ(m.ld() * sizeof(float) % 64, 0);  // rows start on a cache line
+    ASSERT_EQ(m[1][2], 6);
+    ASSERT_EQ(m.at(0, 1), 2);
+    ASSERT_THROW(static_cast<void>(m.at(2)), std::out_of_range);
+    ASSERT_THROW(static_cast<void>(m.at(0, 3)), std::out_of_range);
+
+    size_t r = 0;
+    for (const auto &row : m.rows()) {  // shall be compatible with range for
+        ASSERT_EQ(row.size(), 3);
+        ASSERT_EQ(row, m[r++]);
+    }
+    ASSERT_EQ(r, 2);
+
+    auto col = m.col(1);
+    ASSERT_EQ(col.size(), 2);
+    ASSERT_EQ(col[1], 5);
+    ASSERT_EQ(col.end() - col.begin(), 2);
+    col.at(0) = 7;
+    ASSERT_EQ(m.at(0, 1), 7);
+    ASSERT_THROW(static_cast<void>(col.at(2)), std::out_of_range);
+    ASSERT_THROW(static_cast<void>(m.col(3)), std::out_of_range);
+#if TOY_GEMM_BOUNDS_CHECK
+    ASSERT_DEATH(static_cast<void>(m[2]), "row index out of range");
+    ASSERT_DEATH(static_cast<void>(m[0][3]), "column index out of range");
+#endif
+}
+
+TEST(toy_gemm_dynmat, mat_interop)
+{
+    const Mat<2, 3> m23({1, 2, 3}, {4, 5, 6});
+    const DynMat<int> d23(m23);
+    ASSERT_EQ(d23, (DynMat<int>{{1, 2, 3}, {4, 5, 6}}));
+    ASSERT_EQ((d23.to_mat<2, 3>()), m23);
+    ASSERT_THROW(static_cast<void>(d23.to_mat<3, 2>()), std::length_error);
+
+    const Mat<3, 2> m32 = m23.transpose();
+    ASSERT_EQ(d23.transpose(), DynMat<int>(m32));
+    ASSERT_EQ(DynMat<int>(m23 * m32), d23 * m32);
+    ASSERT_EQ(DynMat<int>(m23 * m32), m23 * DynMat<int>(m32));
+}
+
+TEST(toy_gemm_dynmat, multiplication)
+{
+    const DynMat<int> m43{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12}};
+    const DynMat<int> m44{{14, 32, 50, 68}, {32, 77, 122, 167}, {50, 122, 194, 266}, {68, 167, 266, 365}};
+    ASSERT_EQ(m43 * m43.transpose(), m44);
+    ASSERT_THROW(static_cast<void>(m43 * m43), std::length_error);
+
+    // large enough for the blocked engine, with ragged edges and padded rows
+    constexpr size_t M = 67, K = 129, N = 45;
+    DynMat<double> a(M, K);
+    DynMat<double> b(K, N);
+    for (size_t r = 0; r < M; ++r) {
+        for (size_t c = 0; c < K; ++c) a.at(r, c) = static_cast<double>((r * 3 + c) % 7) - 3;
+    }
+    for (size_t r = 0; r < K; ++r) {
+        for (size_t c = 0; c < N; ++c) b.at(r, c) = static_cast<double>((r + c * 5) % 9) - 4;
+    }
+    const auto ab = a * b;
+    static_assert(std::is_same_v<std::remove_cv_t<decltype(ab)>, DynMat<double>>);
+    for (size_t r = 0; r < M; ++r) {
+        for (size_t c = 0; c < N; ++c) {
+            double expected = 0;
+            for (size_t k = 0; k < K; ++k) expected += a.at(r, k) * b.at(k, c);
+            ASSERT_EQ(ab.at(r, c), expected);
+        }
+    }
+    ASSERT_EQ(DynMat<double>::identity(M) * a, a);
+
+    const auto b_t = b.transpose();
+    ASSERT_EQ(a.transpose_view() * a, a.transpose() * a);
+    ASSERT_EQ(a * b_t.transpose_view(), ab);
+    ASSERT_EQ(b_t.transpose_view().col_count(), N);
+    ASSERT_EQ(b.transpose_view() * a.transpose_view(), ab.transpose());
+    ASSERT_THROW(static_cast<void>(a * a.transpose_view().base()), std::length_error);
+}
+
+TEST(toy_gemm_dynmat, transpose_in_place)
+{
+    const auto make = [](size_t rows, size_t cols) {
+        DynMat<double> m(rows, cols);
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < cols; ++c) m.at(r, c) = static_cast<double>(r * 1000 + c);
+        }
+        return m;
+    };
+    // square, wide, tall, a single row, ragged sizes; the wide ones leave no room for padded rows
+    for (const auto &[rows, cols] : {std::pair<size_t, size_t>{37, 37}, {3, 5}, {5, 3}, {1, 9}, {16, 3}, {45, 70},
+                                     {70, 45}, {64, 8}}) {
+        auto m = make(rows, cols);
+        const auto expected = m.transpose();
+        const double *data = m.data();
+        m.transpose_in_place();
+        ASSERT_EQ(m.data(), data);
+        ASSERT_EQ(m.row_count(), cols);
+        ASSERT_EQ(m.col_count(), rows);
+        ASSERT_GE(m.ld(), rows);
+        ASSERT_EQ(m, expected);
+        ASSERT_EQ(DynMat<double>(m), expected);  // copies have padded rows again
+        ASSERT_EQ(m.transpose_in_place(), make(rows, cols));
+    }
+
+    // the 24 x 3 result of a 3 x 24 matrix needs 24 * 8 elements for padded rows, but 3 x 24 only has 3 * 24
+    auto wide = make(3, 24);
+    wide.transpose_in_place();
+    ASSERT_EQ(wide.ld(), 3);
+    ASSERT_EQ(wide * make(3, 5), wide.transpose().transpose() * make(3, 5));
+}
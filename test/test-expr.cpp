@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <toy-gemm/expr.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+TEST(toy_gemm_expr, elementwise)
+{
+    constexpr Mat<2, 2> x{1, 2, 3, 4};
+    constexpr Mat<2, 2> y{4, 3, 2, 1};
+    static_assert(x + y == Mat<2, 2>{5, 5, 5, 5});
+    static_assert(x - x == Mat<2, 2>::zeros());
+
+    const Mat<2, 2> twice = 2 * x;
+    ASSERT_EQ(twice, x + x);
+    Mat<2, 2> z = x;
+    z -= x * 1;
+    ASSERT_EQ(z, (Mat<2, 2>::zeros()));
+}
+
+TEST(toy_gemm_expr, fused_gemm)
+{
+    constexpr size_t M = 33, K = 47, N = 29;
+    const auto a = make_mat<M, K>(1);
+    const auto b = make_mat<K, N>(2);
+    const auto c0 = make_mat<M, N>(3);
+    const auto ab = a * b;
+
+    auto c = c0;
+    c = 2.0 * a * b + 0.5 * c;
+    ASSERT_EQ(c, (Mat<M, N, double>(2.0 * ab) + Mat<M, N, double>(0.5 * c0)));
+
+    c = c0;
+    c += prod(a, b);
+    ASSERT_EQ(c, c0 + ab);
+    c -= a * 3 * b;
+    ASSERT_EQ(c, (c0 + ab - Mat<M, N, double>(3 * ab)));
+
+    Mat<M, N, double> d = a * (-1 * b) + c0;  // Gemm with beta == 1 into a fresh matrix
+    ASSERT_EQ(d, c0 - ab);
+    d = 1 * a * b - c0;
+    ASSERT_EQ(d, ab - c0);
+}
+
+TEST(toy_gemm_expr, aliasing)
+{
+    // the output is also an operand of the product: must go through a temporary
+    auto a = make_mat<20, 20>(4);
+    const auto b = make_mat<20, 20>(5);
+    const auto ab = a * b;
+    a = 1 * a * b;
+    ASSERT_EQ(a, ab);
+
+    // a transposed view of the output
+    auto s = make_mat<20, 20>(6);
+    const Mat<20, 20, double> s_t = 1 * s.transpose_view();
+    s = 1 * b * b + s.transpose_view();
+    ASSERT_EQ(s, b * b + s_t);
+    const auto s0 = s;
+    s += 1.0 * s.transpose_view();
+    const auto sym = s0 + s0.transpose();
+    ASSERT_EQ(s, sym);
+    s -= 2 * s.transpose_view();
+    ASSERT_EQ(s, sym - sym - sym);
+}
+
+TEST(toy_gemm_expr, aliasing_product_operands)
+{
+    // the output is an operand of the product but not the added matrix; it must not be overwritten by beta * C first
+    const DynMat<double> a0(make_mat<20, 20>(1));
+    const DynMat<double> b0(make_mat<20, 20>(2));
+    const DynMat<double> c(make_mat<20, 20>(3));
+    const auto ab = a0 * b0;
+    auto a = a0;
+    a = 1.0 * a * b0 + 1.0 * c;
+    ASSERT_EQ(a, ab + c);
+    a = a0;
+    a += 1.0 * a * b0 + 1.0 * c;
+    ASSERT_EQ(a, a0 + ab + c);
+    auto b = b0;
+    b = 2.0 * a0 * b - c;
+    ASSERT_EQ(b, ab + ab - c);
+    b = b0;
+    b -= 1.0 * a0 * b + 0.5 * c;
+    ASSERT_EQ(b, b0 - ab - DynMat<double>(0.5 * c));
+
+    // a Mat, with the transposed output as the rhs of the product
+    auto m = make_mat<20, 20>(4);
+    const auto m0 = m;
+    const auto mc = make_mat<20, 20>(5);
+    m = 1.0 * mc * m.transpose_view() + mc;
+    ASSERT_EQ(m, mc * m0.transpose() + mc);
+
+    // a DynMat output that changes shape keeps its elements until the product has read them
+    DynMat<double> r(make_mat<6, 20>(6));
+    const auto r0 = r;
+    r = 1.0 * r * DynMat<double>(make_mat<20, 9>(7));
+    ASSERT_EQ(r, r0 * DynMat<double>(make_mat<20, 9>(7)));
+    ASSERT_EQ(r.col_count(), 9);
+}
+
+TEST(toy_gemm_expr, scalars)
+{
+    static_assert(detail::SCALES_EXACTLY<int, double>);
+    static_assert(detail::SCALES_EXACTLY<double, float>);
+    static_assert(detail::SCALES_EXACTLY<long, int>);
+    static_assert(!detail::SCALES_EXACTLY<double, int>, "0.5 * A into an int matrix would scale by 0");
+    static_assert(!detail::SCALES_EXACTLY<std::complex<double>, int>);
+
+    const DynMat<int> a{{1, 2}, {3, 4}};
+    DynMat<int> c = 3 * a * a;
+    ASSERT_EQ(c, (DynMat<int>{{21, 30}, {45, 66}}));
+    const DynMat<double> d = 0.5 * a;
+    ASSERT_EQ(d, (DynMat<double>{{0.5, 1}, {1.5, 2}}));
+}
+
+TEST(toy_gemm_expr, dynmat)
+{
+    const DynMat<float> a(make_mat<30, 20>(7));
+    const DynMat<float> b(make_mat<20, 25>(8));
+    const auto ab = a * b;
+    DynMat<float> c;
+    c = 2 * a * b;  // reshapes c
+    ASSERT_EQ(c, ab + ab);
+    c = 1 * a * b - c;
+    ASSERT_EQ(c, DynMat<float>(-1 * ab));
+    c += a * (2 * b);
+    ASSERT_EQ(c, ab);
+    ASSERT_THROW(c += prod(b, a), std::length_error);
+}
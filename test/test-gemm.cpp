@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <complex>
+#include <cstdint>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/matrix.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+namespace
+{
+template <size_t R, size_t C, typename T>
+Mat<C, R, T> naive_transpose(const Mat<R, C, T> &m)
+{
+    Mat<C, R, T> ret;
+    for (size_t r = 0; r < R; ++r) {
+        for (size_t c = 0; c < C; ++c) ret.at(c, r) = m.at(r, c);
+    }
+    return ret;
+}
+
+template <size_t R, size_t K, size_t C, typename T, typename E = T>
+void check_product()
+{
+    const auto a = make_mat<R, K, T>(1);
+    const auto b = make_mat<K, C, E>(2);
+    ASSERT_EQ(a * b, naive_product(a, b));
+}
+}  // namespace
+
+TEST(toy_gemm_engine, square)
+{
+    check_product<64, 64, 64, int>();
+    check_product<128, 128, 128, float>();
+    check_product<96, 96, 96, double>();
+}
+
+TEST(toy_gemm_engine, ragged_edges)
+{
+    // none of these are multiples of the register or cache blocks
+    check_product<33, 17, 45, int>();
+    check_product<131, 300, 7, float>();
+    check_product<5, 517, 129, double>();
+    check_product<1, 1000, 1, int>();
+}
+
+TEST(toy_gemm_engine, mixed_and_complex)
+{
+    check_product<40, 30, 20, int, double>();
+    check_product<20, 30, 40, std::complex<double>>();
+}
+
+TEST(toy_gemm_engine, transposed_operands)
+{
+    const auto a = make_mat<57, 83, float>(6);
+    const auto b = make_mat<41, 83, float>(7);
+    const auto a_t = naive_transpose(a);
+    const auto b_t = naive_transpose(b);
+    ASSERT_EQ(a * b.transpose_view(), naive_product(a, b_t));
+    ASSERT_EQ(a * a.transpose_view(), naive_product(a, a_t));  // Gram matrix
+    ASSERT_EQ(a.transpose_view() * a, naive_product(a_t, a));
+    const auto d = make_mat<41, 57, float>(8);
+    ASSERT_EQ(a.transpose_view() * d.transpose_view(), naive_product(a_t, naive_transpose(d)));
+}
+
+TEST(toy_gemm_engine, alpha_beta)
+{
+    constexpr size_t M = 37, N = 29, K = 41;
+    const auto a = make_mat<M, K, double>(3);
+    const auto b = make_mat<K, N, double>(4);
+    auto c = make_mat<M, N, double>(5);
+    const auto expected_ab = naive_product(a, b);
+    const auto c0 = c;
+    engine::gemm(M, N, K, 2.0, engine::StridedView<const double>{a.data(), K, 1},
+                 engine::StridedView<const double>{b.data(), N, 1}, -1.0,
+                 engine::StridedView<double>{c.data(), N, 1});
+    for (size_t r = 0; r < M; ++r) {
+        for (size_t col = 0; col < N; ++col) ASSERT_EQ(c.at(r, col), 2.0 * expected_ab.at(r, col) - c0.at(r, col));
+    }
+}
+
+TEST(toy_gemm_engine, every_isa)
+{
+    const cpu::Isa supported = cpu::supported_isa();
+    for (auto isa : {cpu::Isa::GENERIC, cpu::Isa::SSE4_2, cpu::Isa::AVX2, cpu::Isa::AVX512}) {
+        if (isa > supported) break;
+        ASSERT_EQ(cpu::set_isa(isa), isa);
+        SCOPED_TRACE(cpu::name(isa));
+        check_product<70, 50, 90, float>();
+        check_product<70, 50, 90, double>();
+        check_product<70, 50, 90, int>();
+    }
+    // can't go past what the CPU supports
+    ASSERT_EQ(cpu::set_isa(cpu::Isa::AVX512), supported);
+}
+
+/**
+ * @brief the blocked transpose against element-wise access, in both strided layouts and for DynMat
+ */
+template <size_t R, size_t C, typename T>
+void check_transpose()
+{
+    const auto row = make_mat<R, C, T>(1);
+    const auto t = row.transpose();
+    const Mat<R, C, T, storage::Aligned<64>, layout::ColMajor> col(row);
+    const auto col_t = col.transpose();
+    const auto dyn_t = DynMat<T>(row).transpose();
+    for (size_t r = 0; r < R; ++r) {
+        for (size_t c = 0; c < C; ++c) {
+            ASSERT_EQ(t.at(c, r), row.at(r, c));
+            ASSERT_EQ(col_t.at(c, r), row.at(r, c));
+            ASSERT_EQ(dyn_t.at(c, r), row.at(r, c));
+        }
+    }
+}
+
+TEST(toy_gemm_engine, transpose_every_isa)
+{
+    const cpu::Isa supported = cpu::supported_isa();
+    for (auto isa : {cpu::Isa::GENERIC, cpu::Isa::SSE4_2, cpu::Isa::AVX2, cpu::Isa::AVX512}) {
+        if (isa > supported) break;
+        ASSERT_EQ(cpu::set_isa(isa), isa);
+        SCOPED_TRACE(cpu::name(isa));
+        // ragged against the tiles and the register blocks, and whole ones
+        check_transpose<67, 45, float>();
+        check_transpose<67, 45, double>();
+        check_transpose<67, 45, std::int32_t>();
+        check_transpose<64, 32, float>();
+        check_transpose<32, 64, double>();
+        check_transpose<17, 70, std::int64_t>();
+    }
+    cpu::set_isa(supported);
+}
+
+TEST(toy_gemm_engine, gemm_into)
+{
+    // small (loop) and large (engine) products, with and without accumulation
+    const auto small_a = make_mat<5, 7, int>(1);
+    const auto small_b = make_mat<7, 3, int>(2);
+    auto small_c = make_mat<5, 3, int>(3);
+    const auto small_c0 = small_c;
+    ASSERT_EQ(gemm_into(small_c, small_a, small_b, true), small_c0 + naive_product(small_a, small_b));
+    ASSERT_EQ(small_c.assign_product(small_a, small_b), naive_product(small_a, small_b));
+
+    const auto a = make_mat<70, 50, double>(1);
+    const auto b = make_mat<50, 90, double>(2);
+    Mat<70, 90, double> c = make_mat<70, 90, double>(3);
+    const auto c0 = c;
+    const double *buffer = c.data();
+    gemm_into(c, a, b, true);
+    ASSERT_EQ(c, c0 + naive_product(a, b));
+    gemm_into(c, a, b);
+    ASSERT_EQ(c, naive_product(a, b));
+    ASSERT_EQ(c.data(), buffer);
+
+    constexpr auto constexpr_product = Mat<2>(1, 2, 3, 4).assign_product(Mat<2>(1, 1, 0, 1), Mat<2>(1, 0, 1, 1));
+    static_assert(constexpr_product == Mat<2>(2, 1, 1, 1));
+}
+
+TEST(toy_gemm_engine, multiply_assign)
+{
+    auto m = make_mat<40, 40, double>(1);
+    const auto m0 = m;
+    const auto b = make_mat<40, 40, double>(2);
+    m *= b;
+    ASSERT_EQ(m, naive_product(m0, b));
+
+    // the output may be an operand
+    m = m0;
+    m.assign_product(m, m, true);
+    ASSERT_EQ(m, m0 + naive_product(m0, m0));
+    m = m0;
+    m.assign_product(b, m);
+    ASSERT_EQ(m, naive_product(b, m0));
+
+    auto rect = make_mat<6, 4, int>(3);
+    const auto rect0 = rect;
+    rect *= make_mat<4, 4, int>(4);
+    ASSERT_EQ(rect, naive_product(rect0, make_mat<4, 4, int>(4)));
+}
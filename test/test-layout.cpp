@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/matrix.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+namespace
+{
+using Packed = storage::Packed;
+using Aligned = storage::Aligned<64>;
+using RowMajor = layout::RowMajor;
+using ColMajor = layout::ColMajor;
+using Tiled8 = layout::Tiled<8>;
+using Morton8 = layout::Morton<8>;
+
+/**
+ * @brief A * B with A in layout LA and B in layout LB against the row-major product, which the other tests cover
+ */
+template <size_t M, size_t K, size_t N, typename LA, typename LB, typename S = Packed>
+void expect_product()
+{
+    const auto expected = make_mat<M, K, double>(1) * make_mat<K, N, double>(2);
+    const auto product = make_mat<M, K, double, S, LA>(1) * make_mat<K, N, double, S, LB>(2);
+    static_assert(std::is_same_v<typename decltype(product)::Layout, LA>);
+    EXPECT_EQ(product, expected);
+}
+
+template <size_t M, size_t K, size_t N, typename S = Packed>
+void expect_products()
+{
+    expect_product<M, K, N, RowMajor, ColMajor, S>();
+    expect_product<M, K, N, ColMajor, RowMajor, S>();
+    expect_product<M, K, N, ColMajor, ColMajor, S>();
+    expect_product<M, K, N, Tiled8, Tiled8, S>();
+    expect_product<M, K, N, layout::Tiled<4, 8>, Tiled8, S>();
+    expect_product<M, K, N, layout::Tiled<4, 8>, layout::Tiled<8, 4>, S>();
+    expect_product<M, K, N, Tiled8, RowMajor, S>();
+    expect_product<M, K, N, ColMajor, Tiled8, S>();
+    expect_product<M, K, N, Morton8, Morton8, S>();
+    expect_product<M, K, N, layout::Morton<4>, layout::Morton<4>, S>();
+    expect_product<M, K, N, layout::Morton<4>, Morton8, S>();
+    expect_product<M, K, N, RowMajor, Morton8, S>();
+}
+}  // namespace
+
+TEST(toy_gemm_layout, map)
+{
+    using Map = layout::Tiled<4, 8>::Map<10, 20>;
+    static_assert(Map::ROW_TILES == 3 && Map::COL_TILES == 3 && Map::LINES == 9 && Map::LEN == 32);
+    static_assert(Map::line(5, 17) == 5 && Map::offset(5, 17) == 9);
+    static_assert(sizeof(Mat<10, 20, float, Packed, layout::Tiled<4, 8>>) == 9 * 32 * sizeof(float));
+    static_assert(Mat<3, 5, float, Aligned, ColMajor>::LD == 16);
+
+    Mat<3, 5, int, Packed, ColMajor> m;
+    m.at(2, 1) = 1;
+    ASSERT_EQ(m.data()[1 * 3 + 2], 1);
+    ASSERT_EQ(m.view()(2, 1), 1);
+    ASSERT_EQ(m.view().row_stride, 1);
+    ASSERT_EQ(m.view().col_stride, 3);
+    ASSERT_THROW(static_cast<void>(m.at(3, 0)), std::out_of_range);
+    ASSERT_THROW(static_cast<void>(m.at(0, 5)), std::out_of_range);
+}
+
+TEST(toy_gemm_layout, morton)
+{
+    // 3 x 5 tiles: quadrants of 2 x 3, 2 x 2, 1 x 3 and 1 x 2 tiles, each in Z order again
+    using Map = layout::Morton<2>::Map<6, 10>;
+    static_assert(Map::LINES == 15 && Map::LEN == 4);
+    static_assert(Map::line(0, 0) == 0 && Map::line(0, 2) == 1 && Map::line(0, 4) == 2 && Map::line(2, 0) == 3);
+    static_assert(Map::line(2, 4) == 5 && Map::line(0, 6) == 6 && Map::line(2, 9) == 9 && Map::line(5, 9) == 14);
+    static_assert(Map::offset(5, 9) == 3);
+
+    constexpr Mat<2, 3, int, Packed, Morton8> small(1, 2, 3, 4, 5, 6);
+    static_assert(small == Mat<2, 3>(1, 2, 3, 4, 5, 6));
+    static_assert(small.transpose() == Mat<3, 2>(1, 4, 2, 5, 3, 6));
+    static_assert(small * small.transpose() == Mat<2>(14, 32, 32, 77));
+
+    // round trips through the converting constructor, and native transposes
+    const auto row = make_mat<67, 45, double>(1);
+    const Mat<67, 45, double, storage::Heap<>, layout::Morton<4>> morton(row);
+    ASSERT_EQ((Mat<67, 45, double>(morton)), row);
+    const auto transposed = morton.transpose();
+    static_assert(std::is_same_v<decltype(transposed)::Layout, layout::Morton<4>>);
+    ASSERT_EQ((Mat<45, 67, double>(transposed)), row.transpose());
+    ASSERT_EQ(transposed.transpose(), morton);
+}
+
+TEST(toy_gemm_layout, access)
+{
+    constexpr Mat<2, 3, int, Packed, ColMajor> col(1, 2, 3, 4, 5, 6);
+    constexpr Mat<2, 3, int, Packed, Tiled8> tiled(1, 2, 3, 4, 5, 6);
+    static_assert(col.get<1, 0>() == 4 && tiled.get<1, 0>() == 4);
+    static_assert(col == Mat<2, 3>(1, 2, 3, 4, 5, 6));
+    static_assert(tiled == col);
+    static_assert(col.get_col<1>()[1] == 5 && tiled.get_col<2>()[0] == 3);
+    static_assert(std::get<1>(tiled.col_view<1>()) == 5);
+    static_assert(col.transpose() == Mat<3, 2>(1, 4, 2, 5, 3, 6));
+    static_assert(Mat<3, 3, int, Packed, Tiled8>::identity() == Mat<3>::identity());
+
+    ASSERT_EQ((Mat<2, 3, int, Packed, ColMajor>{{1, 2, 3}, {4, 5, 6}}), col);
+    ASSERT_EQ((Mat<2, 3, int, Packed, Tiled8>(col)), tiled);
+    ASSERT_EQ((Mat<2, 3>(tiled)), col);
+
+    int expected = 1;
+    for (const auto &c : col.cols()) {
+        ASSERT_EQ(c[0], expected++);
+        ASSERT_EQ(c[1], expected + 2);
+    }
+
+    auto sum = tiled + col;
+    sum -= Mat<2, 3>(1);
+    ASSERT_EQ(sum, (Mat<2, 3>(1, 3, 5, 7, 9, 11)));
+    ASSERT_EQ(DynMat<int>(col), DynMat<int>(tiled));
+    ASSERT_EQ((DynMat<int>(col).to_mat<2, 3, Aligned, Tiled8>()), tiled);
+}
+
+TEST(toy_gemm_layout, constexpr_product)
+{
+    constexpr auto a = Mat<3, 2, int, Packed, ColMajor>(1, 2, 3, 4, 5, 6);
+    constexpr auto b = Mat<2, 3, int, Packed, Tiled8>(1, 2, 3, 4, 5, 6);
+    constexpr auto expected = Mat<3, 2>(1, 2, 3, 4, 5, 6) * Mat<2, 3>(1, 2, 3, 4, 5, 6);
+    static_assert(a * b == expected);
+    static_assert(b.transpose() * a.transpose() == expected.transpose());
+    static_assert(a * Mat<2, 3>(1, 2, 3, 4, 5, 6) == expected);
+}
+
+TEST(toy_gemm_layout, loop_products)
+{
+    expect_products<3, 5, 7>();
+    expect_products<16, 9, 13, Aligned>();
+}
+
+TEST(toy_gemm_layout, engine_products)
+{
+    // ragged against the tiles and the microkernels, and large enough for the thread pool
+    expect_products<67, 45, 13>();
+    expect_products<67, 45, 13, Aligned>();
+    expect_products<96, 80, 72>();
+
+    // the Morton product on the thread pool, and serially
+    parallel::set_num_threads(4);
+    expect_product<130, 70, 90, Morton8, Morton8, storage::Heap<>>();
+    parallel::set_num_threads(1);
+    expect_product<130, 70, 90, Morton8, Morton8, storage::Heap<>>();
+    parallel::set_num_threads(0);
+}
+
+TEST(toy_gemm_layout, dynmat)
+{
+    const auto a = make_mat<20, 30, double, Packed, Tiled8>(1);
+    const auto b = make_mat<30, 10, double, Packed, ColMajor>(2);
+    const auto expected = DynMat<double>(a) * DynMat<double>(b);
+    ASSERT_EQ(DynMat<double>(a) * b, expected);
+    ASSERT_EQ(a * DynMat<double>(b), expected);
+    ASSERT_EQ(DynMat<double>(a * b), expected);
+}
+
+TEST(toy_gemm_layout, assign_product)
+{
+    const auto a = make_mat<67, 45, double>(1);
+    const auto b = make_mat<45, 13, double, Packed, Tiled8>(2);
+    const auto expected = a * make_mat<45, 13, double>(2);
+
+    Mat<67, 13, double, Packed, ColMajor> col(1.0);
+    col.assign_product(a, b, true);
+    ASSERT_EQ(col, (expected + Mat<67, 13, double>(1.0)));
+
+    Mat<67, 13, double, Aligned, Tiled8> tiled(1.0);
+    gemm_into(tiled, make_mat<67, 45, double, Packed, Tiled8>(1), b);
+    ASSERT_EQ(tiled, expected);
+    gemm_into(tiled, a, b, true);
+    ASSERT_EQ(tiled, expected + expected);
+}
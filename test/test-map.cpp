@@ -0,0 +1,334 @@
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/expr.hpp>
+#include <toy-gemm/matrix.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+namespace
+{
+/**
+ * @brief a rows x ld buffer holding m from column c0 on, and marks everywhere else
+ */
+template <size_t R, size_t C, typename T>
+std::vector<T> make_buffer(const Mat<R, C, T> &m, size_t ld, size_t c0, T mark)
+{
+    std::vector<T> buffer(R * ld, mark);
+    for (size_t r = 0; r < R; ++r) {
+        for (size_t c = 0; c < C; ++c) buffer[r * ld + c0 + c] = m.at(r, c);
+    }
+    return buffer;
+}
+
+/**
+ * @brief whether every element of a rows x ld buffer outside columns [c0, c0 + cols) still is mark
+ */
+template <typename T>
+bool untouched(const std::vector<T> &buffer, size_t ld, size_t c0, size_t cols, T mark)
+{
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        const size_t c = i % ld;
+        if ((c < c0 || c >= c0 + cols) && buffer[i] != mark) return false;
+    }
+    return true;
+}
+}  // namespace
+
+TEST(toy_gemm_map, mat_ref)
+{
+    const auto m = make_mat<4, 3, int>(1);
+    auto buffer = make_buffer(m, 16, 2, -99);
+    MatRef<4, 3> ref(buffer.data() + 2, 16);
+    ASSERT_EQ(ref.ld(), 16);
+    ASSERT_EQ(ref.data(), buffer.data() + 2);
+    ASSERT_EQ(ref, m);
+    ASSERT_EQ(ref[1][2], m[1][2]);
+    ASSERT_EQ(ref.view().row_stride, 16);
+    ASSERT_EQ(ref.get_col<1>(), m.get_col<1>());
+    ASSERT_THROW(static_cast<void>(ref.at(4, 0)), std::out_of_range);
+    ASSERT_THROW((MatRef<4, 3>(buffer.data(), 2)), std::length_error);
+
+    // copies view the same elements; assignment writes them
+    MatRef<4, 3> copy = ref;
+    copy.at(0, 0) = 42;
+    ASSERT_EQ(buffer[2], 42);
+    ref = m;
+    ASSERT_EQ(buffer[2], m.at(0, 0));
+    ref += m;
+    ASSERT_EQ(ref, m + m);
+    ASSERT_TRUE(untouched(buffer, 16, 2, 3, -99));
+
+    // results own their elements, on the heap
+    static_assert(std::is_same_v<decltype(ref + m), Mat<4, 3, int, storage::Heap<>>>);
+    static_assert(std::is_same_v<decltype(ref.transpose()), Mat<3, 4, int, storage::Heap<>>>);
+    static_assert(std::is_same_v<decltype(ref * m.transpose()), Mat<4, 4, int, storage::Heap<>>>);
+    ASSERT_EQ(ref - m, m);
+    ASSERT_EQ(ref.transpose(), (m + m).transpose());
+
+    const Mat<4, 3> packed(ref);
+    ASSERT_EQ(packed, m + m);
+    ASSERT_EQ(DynMat<int>(ref), DynMat<int>(packed));
+
+    // a read-only view
+    const std::vector<int> values(12, 1);
+    const MatRef<4, 3, const int> read_only(values.data());
+    ASSERT_EQ(read_only, (Mat<4, 3>(1)));
+    ASSERT_EQ(read_only + m, (m + Mat<4, 3>(1)));
+}
+
+TEST(toy_gemm_map, mat_ref_products)
+{
+    // small enough for the loop, and large enough for the engine
+    const auto a = make_mat<5, 7, double>(1);
+    const auto b = make_mat<7, 3, double>(2);
+    auto a_buffer = make_buffer(a, 9, 1, 0.5);
+    auto b_buffer = make_buffer(b, 5, 2, 0.5);
+    const MatRef<5, 7, const double> ra(a_buffer.data() + 1, 9);
+    const MatRef<7, 3, const double> rb(b_buffer.data() + 2, 5);
+    ASSERT_EQ(ra * rb, a * b);
+    ASSERT_EQ((ra * b), a * b);
+    ASSERT_EQ((a * rb), a * b);
+
+    const auto c = make_mat<67, 45, double>(3);
+    const auto d = make_mat<45, 13, double>(4);
+    auto c_buffer = make_buffer(c, 50, 3, 0.5);
+    const MatRef<67, 45, const double> rc(c_buffer.data() + 3, 50);
+    const auto expected = c * d;
+    ASSERT_EQ(rc * d, expected);
+    const auto dt = d.transpose();
+    ASSERT_EQ((rc * dt.transpose_view()), expected);
+    ASSERT_EQ(DynMat<double>(rc) * DynMat<double>(d), DynMat<double>(expected));
+
+    // written through
+    auto out_buffer = make_buffer(Mat<67, 13, double>(1.0), 20, 4, 0.5);
+    MatRef<67, 13, double> out(out_buffer.data() + 4, 20);
+    out.assign_product(rc, d, true);
+    ASSERT_EQ(out, (expected + Mat<67, 13, double>(1.0)));
+    gemm_into(out, c, d);
+    ASSERT_EQ(out, expected);
+    out = 2.0 * rc * d - out;
+    ASSERT_EQ(out, expected);
+    ASSERT_TRUE(untouched(out_buffer, 20, 4, 13, 0.5));
+
+    // column-major and tiled views
+    auto col_buffer = std::vector<double>(13 * 70, 0.5);
+    MatRef<67, 13, double, layout::ColMajor> col(col_buffer.data(), 70);
+    col.assign_product(c, d);
+    ASSERT_EQ(col, expected);
+    Mat<67, 13, double, storage::Packed, layout::Tiled<8>> tiled(expected);
+    MatRef<67, 13, double, layout::Tiled<8>> tiled_ref(tiled.data(), tiled.ld());
+    ASSERT_EQ(tiled_ref, expected);
+    const auto lhs = make_mat<13, 67, double>(5);
+    ASSERT_EQ((Mat<13, 67, double, storage::Packed, layout::Tiled<8>>(lhs) * tiled_ref), lhs * expected);
+}
+
+TEST(toy_gemm_map, mat_ref_aliasing)
+{
+    // a view of a matrix, multiplied into that matrix
+    auto a = make_mat<6, 6, int>(1);
+    const auto expected = a * a;
+    const MatRef<6, 6> view(a.data());
+    a.assign_product(view, view);
+    ASSERT_EQ(a, expected);
+
+    // a view of a block of the buffer the product goes to
+    std::vector<double> buffer(40 * 40);
+    std::iota(buffer.begin(), buffer.end(), 0.0);
+    MatRef<20, 20, double> top(buffer.data(), 40);
+    MatRef<20, 20, double> shifted(buffer.data() + 1, 40);
+    const Mat<20, 20, double> before(shifted);
+    const auto square = before * before;
+    top.assign_product(shifted, shifted);
+    ASSERT_EQ(top, square);
+    top *= Mat<20, 20, double>::identity();
+    ASSERT_EQ(top, square);
+}
+
+TEST(toy_gemm_map, large_views)
+{
+    // 8 MB per 1024 x 1024 matrix of doubles: results and copies of views must not go on the stack
+    constexpr size_t N = 1024;
+    std::vector<double> buffer((N + 1) * N);
+    std::iota(buffer.begin(), buffer.end(), 0.0);
+    const MatRef<N, N, const double> src(buffer.data());
+    const auto sum = src + src;
+    static_assert(std::is_same_v<decltype(sum), const Mat<N, N, double, storage::Heap<>>>);
+    ASSERT_EQ(sum.at(N - 1, N - 1), 2 * buffer[N * N - 1]);
+
+    // overlapping assignment, through a copy in the arena
+    const Mat<N, N, double, storage::Heap<>> before(src);
+    MatRef<N, N, double> dst(buffer.data() + N);
+    dst = MatRef<N, N, double>(buffer.data());
+    ASSERT_EQ(dst, before);
+    dst += src;  // src views the first line of before, then all of before but its last line
+    ASSERT_EQ(dst.at(0, 7), 2 * before.at(0, 7));
+    ASSERT_EQ(dst.at(N - 1, 1), before.at(N - 1, 1) + before.at(N - 2, 1));
+
+    // a product of views
+    const MatRef<N, 64, const double> lhs(buffer.data(), N);
+    const MatRef<64, N, const double> rhs(buffer.data());
+    const auto product = lhs * rhs;
+    ASSERT_EQ(product.at(3, 5), (Mat<1, 64, double>(lhs.block<3, 0, 1, 64>()) * rhs.block<0, 5, 64, 1>()).at(0, 0));
+}
+
+TEST(toy_gemm_map, mat_map)
+{
+    const auto a = make_mat<30, 20, double>(1);
+    const auto b = make_mat<20, 10, double>(2);
+    auto a_buffer = make_buffer(a, 24, 0, 0.5);
+    auto b_buffer = make_buffer(b, 10, 0, 0.5);
+    MatMap<double> ma(a_buffer.data(), 30, 20, 24);
+    const MatMap<const double> mb(b_buffer.data(), 20, 10);
+    ASSERT_EQ(ma.ld(), 24);
+    ASSERT_EQ(ma.at(3, 4), a.at(3, 4));
+    ASSERT_EQ(ma, DynMat<double>(a));
+    ASSERT_THROW(static_cast<void>(ma.at(30)), std::out_of_range);
+    ASSERT_THROW(MatMap<double>(a_buffer.data(), 30, 20, 10), std::length_error);
+    ASSERT_EQ((ma.to_mat<30, 20>()), a);
+
+    const DynMat<double> expected(a * b);
+    ASSERT_EQ(ma * mb, expected);
+    ASSERT_EQ(ma * b, expected);
+    ASSERT_EQ(a * mb, expected);
+    ASSERT_EQ(DynMat<double>(a) * mb, expected);
+    const auto mbt = mb.transpose();
+    ASSERT_EQ(ma * mbt.transpose_view(), expected);
+    ASSERT_EQ(ma.transpose_view() * ma, DynMat<double>(a).transpose() * DynMat<double>(a));
+
+    // elementwise, and written through
+    ma += DynMat<double>(a);
+    ASSERT_EQ(ma, DynMat<double>(a + a));
+    ASSERT_EQ(ma - DynMat<double>(a), DynMat<double>(a));
+    ma = DynMat<double>(a);
+    ASSERT_EQ(ma, DynMat<double>(a));
+    ASSERT_TRUE(untouched(a_buffer, 24, 0, 20, 0.5));
+
+    std::vector<double> out_buffer(30 * 12, 0.5);
+    MatMap<double> out(out_buffer.data(), 30, 10, 12);
+    out = 2.0 * ma * mb;
+    ASSERT_EQ(out, expected + expected);
+    out -= prod(ma, mb);
+    ASSERT_EQ(out, expected);
+    ASSERT_THROW(out = prod(mb, ma), std::length_error);
+    ASSERT_TRUE(untouched(out_buffer, 12, 0, 10, 0.5));
+
+    // overlapping views
+    std::vector<int> values(16);
+    std::iota(values.begin(), values.end(), 0);
+    MatMap<int> head(values.data(), 3, 4);
+    MatMap<int> tail(values.data() + 4, 3, 4);
+    const DynMat<int> tail_before(tail);
+    head = tail;
+    ASSERT_EQ(head, tail_before);
+    std::iota(values.begin(), values.end(), 0);
+    const DynMat<int> head_before(head);
+    tail += head;
+    ASSERT_EQ(tail, tail_before + head_before);
+
+    // blocks of a DynMat, and a DynMat added to itself
+    DynMat<int> d{{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}, {12, 13, 14, 15}};
+    auto lower = d.block(1, 0, 3, 4);
+    const DynMat<int> lower_before(lower);
+    const DynMat<int> upper_before(d.block(0, 0, 3, 4));
+    lower -= d.block(0, 0, 3, 4);
+    ASSERT_EQ(lower, lower_before - upper_before);
+    const DynMat<int> d_before(d);
+    d += d;
+    ASSERT_EQ(d, d_before + d_before);
+
+    // the same for MatRefs, with the destination a line ahead of the source
+    std::vector<int> buffer(20);
+    std::iota(buffer.begin(), buffer.end(), 0);
+    MatRef<4, 4> src(buffer.data());
+    MatRef<4, 4> dst(buffer.data() + 4);
+    const Mat<4, 4> src_before(src);
+    const Mat<4, 4> dst_before(dst);
+    dst = src;
+    ASSERT_EQ(dst, src_before);
+    std::iota(buffer.begin(), buffer.end(), 0);
+    dst += src;
+    ASSERT_EQ(dst, src_before + dst_before);
+    std::iota(buffer.begin(), buffer.end(), 0);
+    dst -= src;
+    ASSERT_EQ(dst, dst_before - src_before);
+    std::iota(buffer.begin(), buffer.end(), 0);
+    MatRef<4, 4, int, layout::ColMajor> dst_t(buffer.data() + 4);
+    dst_t = src;  // another layout
+    ASSERT_EQ(dst_t, src_before);
+}
+
+TEST(toy_gemm_map, block)
+{
+    auto m = make_mat<6, 8, int>(1);
+    const auto original = m;
+    constexpr Mat<2, 3> ones(1);
+
+    auto b = m.block<1, 2, 2, 3>();
+    static_assert(std::is_same_v<decltype(b), MatRef<2, 3>>);
+    ASSERT_EQ(b.at(1, 2), m.at(2, 4));
+    b = ones;
+    ASSERT_EQ(m.at(2, 4), 1);
+    ASSERT_EQ(m.at(0, 0), original.at(0, 0));
+    ASSERT_EQ((m.block<0, 0, 6, 8>()), m);
+    ASSERT_EQ((m.block<1, 2, 4, 4>().block<0, 0, 2, 3>()), ones);
+
+    const auto &cm = m;
+    static_assert(std::is_same_v<decltype(cm.block<0, 0, 2, 2>()), MatRef<2, 2, const int>>);
+    ASSERT_EQ((cm.block<1, 2, 2, 3>()), ones);
+
+    auto col = Mat<6, 8, int, storage::Packed, layout::ColMajor>(original);
+    ASSERT_EQ((col.block<1, 2, 3, 4>()), (original.block<1, 2, 3, 4>()));
+
+    auto rb = m.block(1, 2, 2, 3);
+    static_assert(std::is_same_v<decltype(rb), MatMap<int>>);
+    ASSERT_EQ(rb, DynMat<int>(ones));
+    ASSERT_EQ(cm.block(3, 4, 3, 4), DynMat<int>(original.block<3, 4, 3, 4>()));
+    ASSERT_THROW(static_cast<void>(m.block(4, 0, 3, 1)), std::out_of_range);
+    ASSERT_THROW(static_cast<void>(m.block(0, 9, 0, 0)), std::out_of_range);
+
+    DynMat<int> d(original);
+    auto db = d.block(1, 1, 4, 6);
+    ASSERT_EQ(db.block(1, 0, 2, 3), DynMat<int>(original.block<2, 1, 2, 3>()));
+    db.block(0, 0, 1, 1).at(0, 0) = 100;
+    ASSERT_EQ(d.at(1, 1), 100);
+    ASSERT_THROW(static_cast<void>(d.block(0, 0, 7, 1)), std::out_of_range);
+}
+
+TEST(toy_gemm_map, block_products)
+{
+    // C = A * B one 32 x 32 x 32 panel at a time, the engine writing straight into the blocks of c
+    const auto a = make_mat<64, 96, double>(1);
+    const auto b = make_mat<96, 64, double>(2);
+    Mat<64, 64, double> c;
+    auto c00 = c.block<0, 0, 32, 64>();
+    auto c10 = c.block<32, 0, 32, 64>();
+    c00.assign_product(a.block<0, 0, 32, 48>(), b.block<0, 0, 48, 64>());
+    c00.assign_product(a.block<0, 48, 32, 48>(), b.block<48, 0, 48, 64>(), true);
+    gemm_into(c10, a.block<32, 0, 32, 96>(), b);
+    ASSERT_EQ(c, a * b);
+
+    // the trailing update of a blocked LU factorization, in place
+    auto lu = make_mat<48, 48, double>(3);
+    auto expected = lu;
+    const auto l21 = lu.block<16, 0, 32, 16>();
+    const auto u12 = lu.block<0, 16, 16, 32>();
+    expected.block<16, 16, 32, 32>() -= Mat<32, 16, double>(l21) * Mat<16, 32, double>(u12);
+    auto a22 = lu.block<16, 16, 32, 32>();
+    a22 -= prod(l21, u12);
+    ASSERT_EQ(lu, expected);
+
+    // runtime blocks through expressions
+    DynMat<double> d(a);
+    auto out = d.block(0, 0, 32, 32);
+    out = 2.0 * a.block(0, 0, 32, 96) * b.block(0, 0, 96, 32);
+    ASSERT_EQ(out, DynMat<double>(2.0 * a * b).block(0, 0, 32, 32));
+    // an operand overlapping the output
+    const DynMat<double> top(d.block(0, 0, 32, 96));
+    auto overlap = d.block(16, 0, 32, 32);
+    overlap = prod(d.block(0, 0, 32, 96), b.block<0, 0, 96, 32>());
+    ASSERT_EQ(overlap, (top * b.block<0, 0, 96, 32>()));
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <toy-gemm/expr.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+namespace
+{
+/**
+ * @brief restores the default thread count when a test is done
+ */
+struct ThreadCountGuard {
+    ~ThreadCountGuard() { parallel::set_num_threads(0); }
+};
+}  // namespace
+
+TEST(toy_gemm_parallel, thread_pool)
+{
+    parallel::ThreadPool pool(4);
+    ASSERT_EQ(pool.size(), 4);
+    for (size_t tasks : {0, 1, 3, 1000}) {
+        std::vector<std::atomic<int>> hits(tasks);
+        pool.run(tasks, [&](size_t i) { ++hits[i]; });
+        for (const auto &h : hits) ASSERT_EQ(h, 1);
+    }
+    ASSERT_THROW(pool.run(100, [](size_t i) { if (i == 42) throw std::runtime_error("task failed"); }),
+                 std::runtime_error);
+    std::atomic<size_t> sum{0};
+    pool.run(10, [&](size_t i) { sum += i; });  // still usable after a failed job
+    ASSERT_EQ(sum, 45);
+}
+
+TEST(toy_gemm_parallel, task_range)
+{
+    parallel::TaskRange range;
+    range.reset(3, 10);
+    ASSERT_EQ(range.size(), 7);
+    parallel::TaskRange::Index task;
+    ASSERT_TRUE(range.pop(task));
+    ASSERT_EQ(task, 3);
+    parallel::TaskRange::Index begin;
+    parallel::TaskRange::Index end;
+    ASSERT_TRUE(range.steal(begin, end));  // the back half of [4, 10)
+    ASSERT_EQ(begin, 7);
+    ASSERT_EQ(end, 10);
+    ASSERT_TRUE(range.steal(begin, end));  // rounds up, so a single task can be stolen
+    ASSERT_EQ(begin, 5);
+    ASSERT_EQ(end, 7);
+    ASSERT_TRUE(range.pop(task));
+    ASSERT_EQ(task, 4);
+    ASSERT_FALSE(range.pop(task));
+    ASSERT_FALSE(range.steal(begin, end));
+}
+
+TEST(toy_gemm_parallel, work_stealing)
+{
+    parallel::ThreadPool pool(4);
+    // thread 0 starts on tasks 0 and 1, and each of them waits for the other to start: only another thread stealing
+    // one of them lets both finish, however the threads are scheduled. The timeout only turns a hang into a failure
+    std::vector<std::thread::id> ran_on(8);
+    std::mutex mutex;
+    std::condition_variable started_cv;
+    int started = 0;
+    pool.run(8, [&](size_t i) {
+        if (i < 2) {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++started;
+            started_cv.notify_all();
+            started_cv.wait_for(lock, std::chrono::seconds(30), [&] { return started == 2; });
+        }
+        ran_on[i] = std::this_thread::get_id();
+    });
+    ASSERT_NE(ran_on[0], ran_on[1]);
+
+    // uneven costs, every task still runs exactly once
+    std::vector<std::atomic<int>> hits(997);
+    pool.run(hits.size(), [&](size_t i) {
+        if (i % 97 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++hits[i];
+    });
+    for (const auto &h : hits) ASSERT_EQ(h, 1);
+}
+
+TEST(toy_gemm_parallel, parallel_for)
+{
+    const ThreadCountGuard guard;
+    parallel::set_num_threads(3);
+    ASSERT_EQ(parallel::num_threads(), 3);
+    std::atomic<size_t> count{0};
+    parallel::parallel_for(8, [&](size_t) {
+        parallel::parallel_for(8, [&](size_t) { ++count; });  // nested jobs run serially
+    });
+    ASSERT_EQ(count, 64);
+
+    // a task can't wait for its own job: the new count only takes effect with the next job
+    parallel::parallel_for(8, [](size_t i) {
+        if (i == 0) parallel::set_num_threads(2);
+    });
+    ASSERT_EQ(parallel::num_threads(), 2);
+    count = 0;
+    parallel::parallel_for(8, [&](size_t) { ++count; });
+    ASSERT_EQ(count, 8);
+    parallel::set_num_threads(0);
+    ASSERT_GE(parallel::num_threads(), 1);
+}
+
+TEST(toy_gemm_parallel, gemm)
+{
+    const ThreadCountGuard guard;
+    // ragged in every dimension, skinny ones that can only be cut one way, and one wider than a panel of B
+    const std::vector<std::array<size_t, 3>> shapes{{131, 97, 203}, {517, 5, 129}, {3, 700, 300}, {256, 256, 64},
+                                                    {37, 4200, 300}};
+    for (const auto &[m, n, k] : shapes) {
+        const auto a = make_dyn<float>(m, k, 1);
+        const auto b = make_dyn<float>(k, n, 2);
+        const auto expected = naive_product(a, b);
+        for (size_t threads : {1, 2, 5, 16}) {
+            parallel::set_num_threads(threads);
+            SCOPED_TRACE(threads);
+            ASSERT_EQ(a * b, expected);
+        }
+    }
+
+    // the BLAS-style entry point
+    parallel::set_num_threads(4);
+    const auto a = make_dyn<float>(200, 150, 3);
+    const auto b = make_dyn<float>(150, 170, 4);
+    auto c = make_dyn<float>(200, 170, 5);
+    const auto ab = naive_product(a, b);
+    const auto expected = ab + ab - c;
+    gemm(2.0f, a, b, -1.0f, c);
+    ASSERT_EQ(c, expected);
+}
+
+TEST(toy_gemm_parallel, tile_grid)
+{
+    constexpr auto grid = engine::tile_grid(1000, 1000, 6, 16, 96, 64);
+    static_assert(grid.count() >= 64);
+    static_assert(grid.tile_m % 6 == 0 && grid.tile_n % 16 == 0);
+    static_assert(engine::tile_grid(6, 16, 6, 16, 96, 64).count() == 1);  // can't cut below one microkernel tile
+    static_assert(engine::tile_grid(600, 16, 6, 16, 96, 64).tile_n == 16);
+    static_assert(engine::tile_grid(6000, 16, 6, 16, 96, 2).tile_m == 96);  // never taller than MC
+}
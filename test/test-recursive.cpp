@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/matrix.hpp>
+#include <toy-gemm/recursive.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+TEST(toy_gemm_recursive, products)
+{
+    // ragged against the base case, and splitting each of m, n and k
+    const auto a = make_dyn<double>(301, 75, 1);
+    const auto b = make_dyn<double>(75, 260, 2);
+    const auto expected = a * b;
+    for (size_t threads : {1, 4}) {
+        parallel::set_num_threads(threads);
+        ASSERT_EQ(multiply(a, b, mult::Recursive{}), expected);
+        ASSERT_EQ(multiply(make_dyn<int>(301, 75, 1), make_dyn<int>(75, 260, 2), mult::Recursive{}),
+                  make_dyn<int>(301, 75, 1) * make_dyn<int>(75, 260, 2));
+    }
+    parallel::set_num_threads(0);
+
+    // deep and skinny: k gets split, the halves accumulating
+    const auto x = make_dyn<float>(9, 1000, 3);
+    const auto y = make_dyn<float>(1000, 5, 4);
+    ASSERT_EQ(multiply(x, y, mult::Recursive{}), x * y);
+
+    // views and strided operands
+    const auto block = a.block(1, 2, 150, 70);
+    ASSERT_EQ(multiply(block, b.block(5, 0, 70, 260), mult::Recursive{}),
+              DynMat<double>(block) * DynMat<double>(b.block(5, 0, 70, 260)));
+    ASSERT_EQ(multiply(DynMat<double>(), DynMat<double>(0, 3), mult::Recursive{}), DynMat<double>(0, 3));
+}
+
+TEST(toy_gemm_recursive, mats)
+{
+    const auto a = make_mat<96, 80, double, storage::Packed, layout::ColMajor>(1);
+    const auto b = make_mat<80, 72, double, storage::Aligned<64>>(2);
+    const auto product = multiply(a, b, mult::Recursive{});
+    static_assert(std::is_same_v<decltype(product), const decltype(a * b)>);
+    ASSERT_EQ(product, a * b);
+
+    // alpha and beta
+    const auto dyn_a = DynMat<double>(a);
+    const auto dyn_b = DynMat<double>(b);
+    auto c = make_dyn<double>(96, 72, 3);
+    auto expected = c;
+    engine::gemm(96, 72, 80, 2.0, dyn_a.view(), dyn_b.view(), -1.0, expected.view());
+    engine::gemm(mult::Recursive{}, 96, 72, 80, 2.0, dyn_a.view(), dyn_b.view(), -1.0, c.view());
+    ASSERT_EQ(c, expected);
+}
+
+TEST(toy_gemm_recursive, transpose)
+{
+    const auto a = make_dyn<int>(333, 70, 1);
+    ASSERT_EQ(transpose(a, mult::Recursive{}), a.transpose());
+    ASSERT_EQ(transpose(a.block(3, 4, 100, 50), mult::Recursive{}), a.block(3, 4, 100, 50).transpose());
+
+    const auto m = make_mat<67, 45, float, storage::Aligned<64>, layout::ColMajor>(2);
+    const auto t = transpose(m, mult::Recursive{});
+    static_assert(std::is_same_v<decltype(t), const decltype(m.transpose())>);
+    ASSERT_EQ(t, m.transpose());
+    const auto tiled = make_mat<20, 12, int, storage::Packed, layout::Tiled<8>>(3);
+    ASSERT_EQ(transpose(tiled, mult::Recursive{}), tiled.transpose());
+}
@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/expr.hpp>
+#include <toy-gemm/matrix.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+namespace
+{
+using Aligned = storage::Aligned<64>;
+
+bool is_aligned(const void *p, size_t align) { return reinterpret_cast<std::uintptr_t>(p) % align == 0; }
+}  // namespace
+
+TEST(toy_gemm_storage, layout)
+{
+    static_assert(Mat<3, 5, float>::LD == 5);
+    static_assert(Mat<3, 5, float, Aligned>::LD == 16);
+    static_assert(Mat<3, 16, float, Aligned>::LD == 16);
+    static_assert(Mat<3, 17, double, Aligned>::LD == 24);
+    static_assert(Mat<3, 5, double, storage::Aligned<32>>::LD == 8);
+    static_assert(sizeof(Mat<3, 5, float, Aligned>) == 3 * 16 * sizeof(float));
+    static_assert(alignof(Mat<3, 5, float, Aligned>) == 64);
+
+    Mat<3, 5, float, Aligned> m;
+    ASSERT_TRUE(is_aligned(m.data(), 64));
+    for (size_t r = 0; r < 3; ++r) {
+        ASSERT_TRUE(is_aligned(m[r].data(), 64));
+        ASSERT_EQ(m[r].data(), m.data() + r * decltype(m)::LD);
+    }
+    const auto view = m.view();
+    ASSERT_EQ(view.row_stride, 16);
+    ASSERT_EQ(view.col_stride, 1);
+}
+
+TEST(toy_gemm_storage, ctor)
+{
+    constexpr Mat<2, 3, int, Aligned> m(1, 2, 3, 4, 5, 6);
+    static_assert(m.get<1, 2>() == 6);
+    static_assert(m == Mat<2, 3>(1, 2, 3, 4, 5, 6));
+    static_assert(Mat<2, 3, int, Aligned>(7) == Mat<2, 3>(7));
+
+    const Mat<2, 3, int, Aligned> list{{1, 2, 3}, {4, 5, 6}};
+    ASSERT_EQ(list, m);
+    ASSERT_THROW(static_cast<void>(list.at(2)), std::out_of_range);
+
+    const Mat<2, 3, int, Aligned> converted(Mat<2, 3>(1, 2, 3, 4, 5, 6));
+    ASSERT_EQ(converted, m);
+    ASSERT_EQ((Mat<2, 3>(converted)), m);
+
+    int sum = 0;
+    for (const auto &row : m.rows()) {
+        for (int e : row) sum += e;
+    }
+    ASSERT_EQ(sum, 21);
+}
+
+TEST(toy_gemm_storage, arithmetic)
+{
+    constexpr auto a = Mat<3, 3, int, Aligned>(1, 2, 3, 4, 5, 6, 7, 8, 9);
+    constexpr auto i = Mat<3, 3, int, Aligned>::identity();
+    static_assert(a * i == a);
+    static_assert(i * a == a);
+    static_assert(a.transpose().transpose() == a);
+    static_assert(a + a - a == a);
+
+    const auto b = make_mat<5, 7, float, Aligned>(1);
+    const auto c = make_mat<7, 3, float, Aligned>(2);
+    const auto packed = make_mat<5, 7, float, storage::Packed>(1) * make_mat<7, 3, float, storage::Packed>(2);
+    ASSERT_EQ(b * c, packed);
+    ASSERT_EQ((b * make_mat<7, 3, float, storage::Packed>(2)), packed);
+    ASSERT_EQ((make_mat<5, 7, float, storage::Packed>(1) * c), packed);
+    const auto d = make_mat<5, 7, float, storage::Packed>(3);
+    ASSERT_EQ(b + d, d + b);
+    ASSERT_EQ(b + d - d, b);
+}
+
+TEST(toy_gemm_storage, engine)
+{
+    // large enough for the gemm engine, with rows that are not a whole number of vectors
+    const auto a = make_mat<67, 45, double, Aligned>(1);
+    const auto b = make_mat<45, 13, double, Aligned>(2);
+    const auto ab = a * b;
+    const auto expected = DynMat<double>(a) * DynMat<double>(b);
+    ASSERT_EQ(DynMat<double>(ab), expected);
+    const auto bt = b.transpose();
+    ASSERT_EQ(DynMat<double>(a * bt.transpose_view()), expected);
+    ASSERT_EQ(DynMat<double>(a) * b, expected);
+    ASSERT_EQ((expected.to_mat<67, 13, Aligned>()), ab);
+
+    const auto c = make_mat<67, 13, double, Aligned>(3);
+    Mat<67, 13, double, Aligned> d = c;
+    d += 2.0 * a * b;
+    ASSERT_EQ(d, c + ab + ab);
+}
+
+TEST(toy_gemm_storage, heap)
+{
+    using Big = Mat<1024, 1024, float, storage::Heap<>>;
+    static_assert(sizeof(Big) == sizeof(void *));
+    static_assert(std::is_nothrow_move_constructible_v<Big> && std::is_nothrow_move_assignable_v<Big>);
+
+    Big a;
+    a.at(1023, 1023) = 1;
+    const float *buffer = a.data();
+    Big moved(std::move(a));
+    ASSERT_EQ(moved.data(), buffer);  // a move takes the buffer over, no element gets copied
+    ASSERT_EQ(Big(a), Big::zeros());  // a copy of a moved-from Mat is zero
+    Big zero;
+    zero = a;
+    ASSERT_EQ(zero, Big::zeros());
+    a = Big::identity();              // a moved-from Mat can be assigned to
+    ASSERT_EQ(a.at(1023, 1023), 1);
+
+    Big copy(moved);
+    ASSERT_NE(copy.data(), moved.data());
+    ASSERT_EQ(copy, moved);
+    copy.at(0, 0) = 2;
+    ASSERT_NE(copy, moved);
+    copy = moved;
+    ASSERT_EQ(copy, moved);
+
+    const Big *before = &copy;
+    copy = std::move(moved);  // swaps, so the source stays usable
+    ASSERT_EQ(&copy, before);
+    ASSERT_EQ(moved.at(1023, 1023), 1);
+}
+
+TEST(toy_gemm_storage, heap_arithmetic)
+{
+    using HeapAligned = storage::Heap<Aligned>;
+    const auto a = make_mat<67, 45, double, HeapAligned>(1);
+    const auto b = make_mat<45, 13, double, storage::Heap<>>(2);
+    ASSERT_TRUE(is_aligned(a.data(), 64));
+    ASSERT_EQ(a.view().row_stride, 48);
+
+    const auto expected = make_mat<67, 45, double, storage::Packed>(1) * make_mat<45, 13, double, storage::Packed>(2);
+    ASSERT_EQ(a * b, expected);
+    ASSERT_EQ((Mat<67, 13, double, HeapAligned>(expected)), expected);
+    ASSERT_EQ(a.transpose().transpose(), a);
+
+    const Mat<2, 3, int, storage::Heap<>> small{{1, 2, 3}, {4, 5, 6}};
+    ASSERT_EQ(small, (Mat<2, 3>(1, 2, 3, 4, 5, 6)));
+    ASSERT_EQ(small + small - small, small);
+    ASSERT_EQ((small * Mat<3, 3, int, storage::Heap<>>::identity()), small);
+    ASSERT_EQ(small.get_col<1>()[1], 5);
+}
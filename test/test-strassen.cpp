@@ -0,0 +1,86 @@
+#include <cmath>
+#include <gtest/gtest.h>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/matrix.hpp>
+#include <toy-gemm/strassen.hpp>
+#include "test-util.hpp"
+
+using namespace toy_gemm;
+using namespace toy_gemm::test;
+
+TEST(toy_gemm_strassen, exact_for_integers)
+{
+    // 3 levels, every dimension even all the way down
+    const auto a = make_dyn<int>(128, 128, 1);
+    const auto b = make_dyn<int>(128, 128, 2);
+    const auto expected = a * b;
+    ASSERT_EQ(multiply(a, b, mult::Strassen{16}), expected);
+    ASSERT_EQ(multiply(a, b, mult::Winograd{16}), expected);
+    ASSERT_EQ(multiply(a, b, mult::Blocked{}), expected);
+    // below the crossover, both are the blocked engine
+    ASSERT_EQ(multiply(a, b, mult::Strassen{}), expected);
+}
+
+TEST(toy_gemm_strassen, padding)
+{
+    // odd, ragged and rectangular: padded to multiples of 8 for 3 levels
+    const auto a = make_dyn<int>(101, 67, 1);
+    const auto b = make_dyn<int>(67, 83, 2);
+    const auto expected = a * b;
+    ASSERT_EQ(multiply(a, b, mult::Strassen{8}), expected);
+    ASSERT_EQ(multiply(a, b, mult::Winograd{8}), expected);
+    ASSERT_EQ(multiply(a, b, mult::Winograd{0}), expected);  // all the way down to 1 x 1
+
+    // views of part of a larger matrix
+    const auto big = make_dyn<int>(120, 120, 3);
+    const auto block = big.block(3, 5, 101, 67);
+    ASSERT_EQ(multiply(block, b, mult::Winograd{8}), DynMat<int>(block) * b);
+}
+
+TEST(toy_gemm_strassen, rounding)
+{
+    // not exactly representable, so every order of the additions rounds differently
+    auto a = make_dyn<double>(256, 256, 1);
+    auto b = make_dyn<double>(256, 256, 2);
+    for (size_t r = 0; r < 256; ++r) {
+        for (size_t c = 0; c < 256; ++c) {
+            a.at(r, c) *= 0.1;
+            b.at(r, c) *= 0.3;
+        }
+    }
+    const auto expected = a * b;
+    EXPECT_LT(max_abs_diff(multiply(a, b, mult::Strassen{32}), expected), 1e-10);
+    EXPECT_LT(max_abs_diff(multiply(a, b, mult::Winograd{32}), expected), 1e-10);
+}
+
+TEST(toy_gemm_strassen, mats)
+{
+    const auto a = make_mat<72, 40, double>(1);
+    const auto b = make_mat<40, 56, double, storage::Aligned<64>, layout::ColMajor>(2);
+    const auto expected = a * b;
+    const auto product = multiply(a, b, mult::Winograd{8});
+    static_assert(std::is_same_v<decltype(product), decltype(expected)>);
+    ASSERT_EQ(DynMat<double>(product), DynMat<double>(expected));
+
+    // tiled operands and results go through row-major copies
+    const auto tiled = make_mat<72, 40, int, storage::Packed, layout::Tiled<8>>(1);
+    const auto rhs = make_mat<40, 56, int, storage::Packed, layout::Tiled<8>>(2);
+    const auto tiled_product = multiply(tiled, rhs, mult::Strassen{8});
+    static_assert(std::is_same_v<decltype(tiled_product)::Layout, layout::Tiled<8>>);
+    ASSERT_EQ(tiled_product, tiled * rhs);
+}
+
+TEST(toy_gemm_strassen, engine)
+{
+    // alpha and beta go through a padded buffer for the product
+    const auto a = make_dyn<int>(70, 50, 1);
+    const auto b = make_dyn<int>(50, 60, 2);
+    auto c = make_dyn<int>(70, 60, 3);
+    auto expected = c;
+    engine::gemm(70, 60, 50, 2, a.view(), b.view(), 3, expected.view());
+    engine::gemm(mult::Winograd{8}, 70, 60, 50, 2, a.view(), b.view(), 3, c.view());
+    ASSERT_EQ(c, expected);
+
+    // the fast path leaves nothing in use in the arena
+    ASSERT_EQ(arena::stats().bytes_in_use, 0);
+}
@@ -0,0 +1,95 @@
+#ifndef TOY_GEMM_TEST_UTIL_HPP
+#define TOY_GEMM_TEST_UTIL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <toy-gemm/dyn_matrix.hpp>
+#include <toy-gemm/matrix.hpp>
+
+/**
+ * Fixtures shared by the tests: matrices of small integers in [-5, 5], which every element type holds exactly, float
+ * included, and reference results computed the obvious way
+ */
+
+namespace toy_gemm
+{
+namespace test
+{
+/**
+ * @return element (r, c) of the matrix made from seed; different seeds give different matrices
+ */
+template <typename T>
+[[nodiscard]] constexpr T make_value(size_t r, size_t c, size_t seed) noexcept
+{
+    return static_cast<T>(static_cast<int>((r * 7 + c * 13 + seed * 5) % 11) - 5);
+}
+
+template <size_t R, size_t C, typename T = double, typename S = storage::Packed, typename L = layout::RowMajor>
+[[nodiscard]] constexpr Mat<R, C, T, S, L> make_mat(size_t seed)
+{
+    Mat<R, C, T, S, L> m;
+    for (size_t r = 0; r < R; ++r) {
+        for (size_t c = 0; c < C; ++c) m.at(r, c) = make_value<T>(r, c, seed);
+    }
+    return m;
+}
+
+template <typename T = double>
+[[nodiscard]] DynMat<T> make_dyn(size_t rows, size_t cols, size_t seed)
+{
+    DynMat<T> m(rows, cols);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < cols; ++c) m.at(r, c) = make_value<T>(r, c, seed);
+    }
+    return m;
+}
+
+/**
+ * @brief a * b by the textbook triple loop
+ */
+template <size_t R, size_t K, size_t C, typename T, typename E>
+[[nodiscard]] auto naive_product(const Mat<R, K, T> &a, const Mat<K, C, E> &b)
+{
+    using RetElement = decltype(std::declval<E>() * std::declval<T>());
+    Mat<R, C, RetElement> ret;
+    for (size_t r = 0; r < R; ++r) {
+        for (size_t c = 0; c < C; ++c) {
+            RetElement acc{};
+            for (size_t k = 0; k < K; ++k) acc += a.at(r, k) * b.at(k, c);
+            ret.at(r, c) = acc;
+        }
+    }
+    return ret;
+}
+
+template <typename T>
+[[nodiscard]] DynMat<T> naive_product(const DynMat<T> &a, const DynMat<T> &b)
+{
+    DynMat<T> ret(a.row_count(), b.col_count());
+    for (size_t r = 0; r < a.row_count(); ++r) {
+        for (size_t c = 0; c < b.col_count(); ++c) {
+            T acc{};
+            for (size_t k = 0; k < a.col_count(); ++k) acc += a.at(r, k) * b.at(k, c);
+            ret.at(r, c) = acc;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @return the largest difference between two elements at the same position of a and b, which have the same shape
+ */
+template <typename T>
+[[nodiscard]] T max_abs_diff(const DynMat<T> &a, const DynMat<T> &b)
+{
+    T ret{};
+    for (size_t r = 0; r < a.row_count(); ++r) {
+        for (size_t c = 0; c < a.col_count(); ++c) ret = std::max(ret, std::abs(a.at(r, c) - b.at(r, c)));
+    }
+    return ret;
+}
+}  // namespace test
+}  // namespace toy_gemm
+
+#endif  // TOY_GEMM_TEST_UTIL_HPP